@@ -0,0 +1,389 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Measures the frame time of every filter in the plugin, running libobs without any window or frontend. Each filter is
+// put on a synthetic pattern source and rendered for a number of frames, after which the distribution of frame times
+// is printed. The time includes reading the result back, so that the GPU has to actually finish the work, and the
+// "Passthrough" line shows how much of it is spent outside of the filters. Frame times are in milliseconds.
+//
+// Usage: benchmark-filters [frames] [filter] [module binary] [module data]
+//
+// On Linux, libobs-opengl still needs an X display. Machines without a GPU can run the benchmark through xvfb-run,
+// in which case Mesa falls back to llvmpipe on its own. Set LIBGL_ALWAYS_SOFTWARE=1 to force llvmpipe everywhere, so
+// that results from different machines can be compared with each other.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "strings.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs-module.h>
+#include <obs.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#define PATTERN_ID "benchmark-pattern"
+#define PATTERN_WIDTH 1920
+#define PATTERN_HEIGHT 1080
+#define WARMUP_FRAMES 30
+
+#if defined(_WIN32)
+#define GRAPHICS_MODULE "libobs-d3d11"
+#else
+#define GRAPHICS_MODULE "libobs-opengl"
+#endif
+
+struct benchmark_case {
+	const char*                       name;
+	const char*                       id;
+	std::function<void(obs_data_t*)> setup;
+};
+
+static std::string module_data_path;
+
+static std::vector<benchmark_case> cases()
+{
+	auto blur = [](const char* type, const char* subtype) {
+		return [type, subtype](obs_data_t* data) {
+			obs_data_set_string(data, "Filter.Blur.Type", type);
+			obs_data_set_string(data, "Filter.Blur.SubType", subtype);
+			obs_data_set_double(data, "Filter.Blur.Size", 15.);
+			obs_data_set_double(data, "Filter.Blur.Angle", 30.);
+		};
+	};
+	// Shrinking the 1080p pattern to 5% is where mipmapping matters, as otherwise most texels are skipped entirely.
+	auto downscale = [](bool mipmapping) {
+		return [mipmapping](obs_data_t* data) {
+			obs_data_set_double(data, "Filter.Transform.Scale.X", 5.);
+			obs_data_set_double(data, "Filter.Transform.Scale.Y", 5.);
+			obs_data_set_double(data, "Filter.Transform.Rotation.Z", 45.);
+			obs_data_set_bool(data, "Filter.Transform.Mipmapping", mipmapping);
+		};
+	};
+
+	return {
+		{"Passthrough", nullptr, nullptr},
+		{"Blur (Box, Area)", PREFIX "filter-blur", blur("box", "area")},
+		{"Blur (Box Linear, Area)", PREFIX "filter-blur", blur("box_linear", "area")},
+		{"Blur (Gaussian, Area)", PREFIX "filter-blur", blur("gaussian", "area")},
+		{"Blur (Gaussian Linear, Area)", PREFIX "filter-blur", blur("gaussian_linear", "area")},
+		{"Blur (Dual Filtering, Area)", PREFIX "filter-blur", blur("dual_filtering", "area")},
+		{"Blur (Gaussian, Directional)", PREFIX "filter-blur", blur("gaussian", "directional")},
+		{"Blur (Gaussian, Rotational)", PREFIX "filter-blur", blur("gaussian", "rotational")},
+		{"Blur (Gaussian, Zoom)", PREFIX "filter-blur", blur("gaussian", "zoom")},
+		{"SDF Effects", PREFIX "filter-sdf-effects",
+		 [](obs_data_t* data) {
+			 obs_data_set_bool(data, "Filter.SDFEffects.Shadow.Outer", true);
+			 obs_data_set_bool(data, "Filter.SDFEffects.Shadow.Inner", true);
+			 obs_data_set_bool(data, "Filter.SDFEffects.Glow.Outer", true);
+			 obs_data_set_bool(data, "Filter.SDFEffects.Outline", true);
+		 }},
+		{"Color Grade", PREFIX "filter-color-grade", nullptr},
+		{"Transform", PREFIX "filter-transform",
+		 [](obs_data_t* data) {
+			 obs_data_set_double(data, "Filter.Transform.Rotation.X", 15.);
+			 obs_data_set_double(data, "Filter.Transform.Rotation.Y", 30.);
+			 obs_data_set_double(data, "Filter.Transform.Rotation.Z", 45.);
+			 obs_data_set_bool(data, "Filter.Transform.Mipmapping", true);
+		 }},
+		{"Transform (Downscale)", PREFIX "filter-transform", downscale(false)},
+		{"Transform (Downscale, Mipmapped)", PREFIX "filter-transform", downscale(true)},
+		{"Dynamic Mask", PREFIX "filter-dynamic-mask",
+		 [](obs_data_t* data) { obs_data_set_string(data, "Filter.DynamicMask.Input", "Benchmark Mask"); }},
+		{"Displacement", PREFIX "filter-displacement", nullptr},
+		{"Shader", PREFIX "filter-shader",
+		 [](obs_data_t* data) {
+			 std::string file = module_data_path + "/examples/shaders/filter/hexagonize.effect";
+			 obs_data_set_string(data, "Shader.Shader.File", file.c_str());
+			 obs_data_set_string(data, "Shader.Shader.Technique", "Draw");
+		 }},
+	};
+}
+
+//--------------------------------------------------------------------------------//
+// Synthetic Source
+//--------------------------------------------------------------------------------//
+
+struct pattern_data {
+	gs_texture_t* texture;
+};
+
+// Gradients with an opaque disc in the middle, so that filters working on color and on alpha both have edges to work
+// with. The pattern is static, which keeps the timings independent of the content.
+static void* pattern_create(obs_data_t*, obs_source_t*)
+{
+	std::vector<uint8_t> pixels(PATTERN_WIDTH * PATTERN_HEIGHT * 4);
+	for (std::size_t y = 0; y < PATTERN_HEIGHT; y++) {
+		for (std::size_t x = 0; x < PATTERN_WIDTH; x++) {
+			uint8_t* px   = &pixels[(y * PATTERN_WIDTH + x) * 4];
+			double_t dx   = (static_cast<double_t>(x) / PATTERN_WIDTH) - .5;
+			double_t dy   = (static_cast<double_t>(y) / PATTERN_HEIGHT) - .5;
+			double_t dist = std::sqrt(dx * dx + dy * dy);
+			bool     tile = ((x / 64) + (y / 64)) & 1;
+
+			px[0] = static_cast<uint8_t>((x * 255) / PATTERN_WIDTH);
+			px[1] = static_cast<uint8_t>((y * 255) / PATTERN_HEIGHT);
+			px[2] = tile ? 255 : 64;
+			px[3] = static_cast<uint8_t>(std::clamp((.4 - dist) * 2550., 0., 255.));
+		}
+	}
+
+	auto           data = new pattern_data{};
+	const uint8_t* mips = pixels.data();
+	obs_enter_graphics();
+	data->texture = gs_texture_create(PATTERN_WIDTH, PATTERN_HEIGHT, GS_RGBA, 1, &mips, 0);
+	obs_leave_graphics();
+	return data;
+}
+
+static void pattern_destroy(void* ptr)
+{
+	auto data = reinterpret_cast<pattern_data*>(ptr);
+	obs_enter_graphics();
+	gs_texture_destroy(data->texture);
+	obs_leave_graphics();
+	delete data;
+}
+
+static void pattern_render(void* ptr, gs_effect_t*)
+{
+	auto         data   = reinterpret_cast<pattern_data*>(ptr);
+	gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), data->texture);
+	while (gs_effect_loop(effect, "Draw")) {
+		gs_draw_sprite(data->texture, 0, PATTERN_WIDTH, PATTERN_HEIGHT);
+	}
+}
+
+static void register_pattern()
+{
+	obs_source_info info = {};
+	info.id              = PATTERN_ID;
+	info.type            = OBS_SOURCE_TYPE_INPUT;
+	info.output_flags    = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
+	info.get_name        = [](void*) { return "Benchmark Pattern"; };
+	info.create          = pattern_create;
+	info.destroy         = pattern_destroy;
+	info.get_width       = [](void*) { return static_cast<uint32_t>(PATTERN_WIDTH); };
+	info.get_height      = [](void*) { return static_cast<uint32_t>(PATTERN_HEIGHT); };
+	info.video_render    = pattern_render;
+	obs_register_source(&info);
+}
+
+//--------------------------------------------------------------------------------//
+// Measurement
+//--------------------------------------------------------------------------------//
+
+struct measurement {
+	obs_source_t*           source;
+	gs_texrender_t*         rt;
+	gs_stagesurf_t*         stage;
+	std::size_t             frames;
+	std::size_t             skip;
+	std::vector<double_t>   times;
+	std::mutex              lock;
+	std::condition_variable done;
+};
+
+// Filters only do their work once per video tick and reuse the result for any further render in the same tick, so
+// frames are rendered from the graphics thread of libobs, right after it ticked every source.
+static void render_frame(void* ptr, uint32_t, uint32_t)
+{
+	auto m   = reinterpret_cast<measurement*>(ptr);
+	vec4 clr = {0., 0., 0., 0.};
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	gs_texrender_reset(m->rt);
+	if (gs_texrender_begin(m->rt, PATTERN_WIDTH, PATTERN_HEIGHT)) {
+		gs_ortho(0., PATTERN_WIDTH, 0., PATTERN_HEIGHT, -1., 1.);
+		gs_clear(GS_CLEAR_COLOR, &clr, 0., 0);
+		obs_source_video_render(m->source);
+		gs_texrender_end(m->rt);
+	}
+
+	// Mapping blocks until the GPU is done with everything that led up to the copy.
+	uint8_t* data     = nullptr;
+	uint32_t linesize = 0;
+	gs_stage_texture(m->stage, gs_texrender_get_texture(m->rt));
+	if (gs_stagesurface_map(m->stage, &data, &linesize)) {
+		gs_stagesurface_unmap(m->stage);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::unique_lock<std::mutex> ul(m->lock);
+	if (m->skip > 0) {
+		m->skip--;
+	} else if (m->times.size() < m->frames) {
+		m->times.push_back(std::chrono::duration<double_t, std::milli>(end - begin).count());
+		if (m->times.size() == m->frames) {
+			m->done.notify_all();
+		}
+	}
+}
+
+static double_t percentile(const std::vector<double_t>& sorted, double_t p)
+{
+	std::size_t rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+	return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static bool run(const benchmark_case& bc, obs_source_t* source, std::size_t frames)
+{
+	obs_source_t* filter = nullptr;
+	if (bc.id) {
+		obs_data_t* settings = obs_data_create();
+		if (bc.setup) {
+			bc.setup(settings);
+		}
+		filter = obs_source_create_private(bc.id, bc.name, settings);
+		obs_data_release(settings);
+		if (!filter) {
+			std::printf("%-32s %s\n", bc.name, "(not available)");
+			return false;
+		}
+		obs_source_filter_add(source, filter);
+	}
+
+	measurement m;
+	m.source = source;
+	m.frames = frames;
+	m.skip   = WARMUP_FRAMES;
+	m.times.reserve(frames);
+	obs_enter_graphics();
+	m.rt    = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+	m.stage = gs_stagesurface_create(PATTERN_WIDTH, PATTERN_HEIGHT, GS_RGBA);
+	obs_leave_graphics();
+
+	obs_add_main_render_callback(render_frame, &m);
+	{
+		std::unique_lock<std::mutex> ul(m.lock);
+		m.done.wait(ul, [&m]() { return m.times.size() >= m.frames; });
+	}
+	obs_remove_main_render_callback(render_frame, &m);
+
+	obs_enter_graphics();
+	gs_stagesurface_destroy(m.stage);
+	gs_texrender_destroy(m.rt);
+	obs_leave_graphics();
+
+	if (filter) {
+		obs_source_filter_remove(source, filter);
+		obs_source_release(filter);
+	}
+
+	std::sort(m.times.begin(), m.times.end());
+	std::printf("%-32s %9.3f %9.3f %9.3f %9.3f %9.3f\n", bc.name, m.times.front(), percentile(m.times, .5),
+				percentile(m.times, .9), percentile(m.times, .99), m.times.back());
+	return true;
+}
+
+int main(int argc, const char* argv[])
+{
+	std::size_t frames = 300;
+	const char* match  = nullptr;
+	std::string module_binary{BENCHMARK_MODULE_BINARY};
+	module_data_path = BENCHMARK_MODULE_DATA;
+	if (argc > 1) {
+		frames = std::max<std::size_t>(static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)), 1);
+	}
+	if (argc > 2) {
+		match = argv[2];
+	}
+	if (argc > 3) {
+		module_binary = argv[3];
+	}
+	if (argc > 4) {
+		module_data_path = argv[4];
+	}
+
+	if (!obs_startup("en-US", nullptr, nullptr)) {
+		std::fprintf(stderr, "Failed to start libobs.\n");
+		return 1;
+	}
+
+	{
+		obs_video_info ovi = {};
+		ovi.graphics_module = GRAPHICS_MODULE;
+		ovi.fps_num         = 60;
+		ovi.fps_den         = 1;
+		ovi.base_width      = PATTERN_WIDTH;
+		ovi.base_height     = PATTERN_HEIGHT;
+		ovi.output_width    = PATTERN_WIDTH;
+		ovi.output_height   = PATTERN_HEIGHT;
+		ovi.output_format   = VIDEO_FORMAT_NV12;
+		ovi.adapter         = 0;
+		ovi.gpu_conversion  = true;
+		ovi.colorspace      = VIDEO_CS_709;
+		ovi.range           = VIDEO_RANGE_PARTIAL;
+		ovi.scale_type      = OBS_SCALE_BICUBIC;
+		if (int error = obs_reset_video(&ovi); error != OBS_VIDEO_SUCCESS) {
+			std::fprintf(stderr, "Failed to initialize video with '%s' (error %d).\n", GRAPHICS_MODULE, error);
+			obs_shutdown();
+			return 1;
+		}
+	}
+
+	register_pattern();
+
+	obs_module_t* module = nullptr;
+	if (obs_open_module(&module, module_binary.c_str(), module_data_path.c_str()) != MODULE_SUCCESS) {
+		std::fprintf(stderr, "Failed to open module '%s'.\n", module_binary.c_str());
+		obs_shutdown();
+		return 1;
+	}
+	if (!obs_init_module(module)) {
+		std::fprintf(stderr, "Failed to initialize module '%s'.\n", module_binary.c_str());
+		obs_shutdown();
+		return 1;
+	}
+	obs_post_load_modules();
+
+	obs_enter_graphics();
+	std::printf("%s, %dx%d, %zu frames\n", gs_get_device_name(), PATTERN_WIDTH, PATTERN_HEIGHT, frames);
+	obs_leave_graphics();
+	std::printf("%-32s %9s %9s %9s %9s %9s\n", "Filter (ms)", "Min", "P50", "P90", "P99", "Max");
+
+	// The mask source has to be a named source, Dynamic Mask looks its input up by name.
+	obs_source_t* source = obs_source_create_private(PATTERN_ID, "Benchmark Pattern", nullptr);
+	obs_source_t* mask   = obs_source_create(PATTERN_ID, "Benchmark Mask", nullptr, nullptr);
+	for (auto& bc : cases()) {
+		if (match && !std::strstr(bc.name, match)) {
+			continue;
+		}
+		run(bc, source, frames);
+	}
+	obs_source_release(mask);
+	obs_source_release(source);
+
+	obs_shutdown();
+	return 0;
+}
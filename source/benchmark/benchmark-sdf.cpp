@@ -0,0 +1,354 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Checks the Jump Flooding distance field of the SDF Effects filter against an exact Euclidean distance transform.
+// The passes of data/effects/sdf/sdf-producer.effect are replayed on the CPU, with the same seed layout, sampling and
+// pass schedule as the filter, and compared texel by texel with the exact result for a set of synthetic shapes. Exits
+// with a non-zero code if any texel is further off than the tolerance.
+//
+// Usage: benchmark-sdf [width] [height]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Largest error in texels that Jump Flooding with one extra unit step is allowed to make. It is not exact: a few texels
+//  between small, separated shapes can lose their nearest seed early, which costs up to about one and a half texels.
+#define TOLERANCE 2.0f
+
+#define NO_SEED -1.0f
+
+struct field {
+	std::size_t        width;
+	std::size_t        height;
+	std::vector<float> inside;  // Distance to the nearest outside texel, for inside texels.
+	std::vector<float> outside; // Distance to the nearest inside texel, for outside texels.
+};
+
+typedef std::vector<uint8_t> mask_t;
+
+//--------------------------------------------------------------------------------//
+// Reference: Exact Euclidean Distance Transform
+//--------------------------------------------------------------------------------//
+
+// One dimensional squared distance transform by Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled
+// Functions", which finds the lower envelope of the parabolas rooted at every sample.
+static void edt_1d(const float* f, float* d, std::size_t n, std::size_t stride, std::vector<std::size_t>& v,
+				   std::vector<float>& z)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	// Samples at infinity have no parabola, so only the others take part in the envelope.
+	int64_t k = -1;
+	for (std::size_t q = 0; q < n; q++) {
+		float fq = f[q * stride];
+		if (fq == inf) {
+			continue;
+		}
+
+		float s = -inf;
+		while (k >= 0) {
+			float fv = f[v[k] * stride];
+			float qf = static_cast<float>(q), vf = static_cast<float>(v[k]);
+			s        = ((fq + qf * qf) - (fv + vf * vf)) / (2.f * (qf - vf));
+			if (s > z[k]) {
+				break;
+			}
+			k--;
+		}
+		k++;
+		v[k]     = q;
+		z[k]     = (k == 0) ? -inf : s;
+		z[k + 1] = inf;
+	}
+
+	if (k < 0) {
+		for (std::size_t q = 0; q < n; q++) {
+			d[q * stride] = inf;
+		}
+		return;
+	}
+
+	k = 0;
+	for (std::size_t q = 0; q < n; q++) {
+		while (z[k + 1] < static_cast<float>(q)) {
+			k++;
+		}
+		float dq      = static_cast<float>(q) - static_cast<float>(v[k]);
+		d[q * stride] = dq * dq + f[v[k] * stride];
+	}
+}
+
+// Distance from every texel to the nearest texel whose mask value matches seed.
+static std::vector<float> edt(const mask_t& mask, std::size_t width, std::size_t height, bool seed)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	std::vector<float>       f(width * height), d(width * height);
+	std::vector<std::size_t> v(std::max(width, height));
+	std::vector<float>       z(std::max(width, height) + 1);
+	for (std::size_t idx = 0; idx < mask.size(); idx++) {
+		f[idx] = ((mask[idx] != 0) == seed) ? 0.f : inf;
+	}
+
+	for (std::size_t x = 0; x < width; x++) {
+		edt_1d(&f[x], &d[x], height, width, v, z);
+	}
+	for (std::size_t y = 0; y < height; y++) {
+		edt_1d(&d[y * width], &f[y * width], width, 1, v, z);
+	}
+	for (auto& value : f) {
+		value = std::sqrt(value);
+	}
+	return f;
+}
+
+static field reference(const mask_t& mask, std::size_t width, std::size_t height)
+{
+	field result{width, height, edt(mask, width, height, false), edt(mask, width, height, true)};
+	for (std::size_t idx = 0; idx < mask.size(); idx++) {
+		(mask[idx] ? result.outside : result.inside)[idx] = 0.f;
+	}
+	return result;
+}
+
+//--------------------------------------------------------------------------------//
+// Jump Flooding, as done by sdf-producer.effect
+//--------------------------------------------------------------------------------//
+
+struct seeds {
+	float inside[2];
+	float outside[2];
+};
+
+static field jump_flooding(const mask_t& mask, std::size_t width, std::size_t height)
+{
+	const float size[2] = {static_cast<float>(width), static_cast<float>(height)};
+
+	std::vector<seeds> front(width * height), back(width * height);
+	auto               uv_of = [&size](std::size_t x, std::size_t y, float* uv) {
+		uv[0] = (static_cast<float>(x) + .5f) / size[0];
+		uv[1] = (static_cast<float>(y) + .5f) / size[1];
+	};
+	auto distance = [&size](const float* here, const float* seed) {
+		float dx = (here[0] - seed[0]) * size[0];
+		float dy = (here[1] - seed[1]) * size[1];
+		return std::sqrt(dx * dx + dy * dy);
+	};
+
+	// Seed
+	for (std::size_t y = 0; y < height; y++) {
+		for (std::size_t x = 0; x < width; x++) {
+			seeds& s = front[y * width + x];
+			float  uv[2];
+			uv_of(x, y, uv);
+			if (mask[y * width + x]) {
+				s = {{uv[0], uv[1]}, {NO_SEED, NO_SEED}};
+			} else {
+				s = {{NO_SEED, NO_SEED}, {uv[0], uv[1]}};
+			}
+		}
+	}
+
+	// Jump, with the same schedule as the filter: halving steps from the largest power of two below the size, then
+	//  one more unit step. Samples outside of the texture are clamped to the edge, like the Clamp address mode.
+	auto jump = [&](uint32_t step) {
+		for (std::size_t y = 0; y < height; y++) {
+			for (std::size_t x = 0; x < width; x++) {
+				float here[2];
+				uv_of(x, y, here);
+				seeds out            = {{NO_SEED, NO_SEED}, {NO_SEED, NO_SEED}};
+				float lowest_inside  = std::numeric_limits<float>::infinity();
+				float lowest_outside = std::numeric_limits<float>::infinity();
+				for (int32_t ox = -1; ox <= 1; ox++) {
+					for (int32_t oy = -1; oy <= 1; oy++) {
+						int64_t sx = std::clamp<int64_t>(static_cast<int64_t>(x) + ox * int64_t(step), 0, width - 1);
+						int64_t sy = std::clamp<int64_t>(static_cast<int64_t>(y) + oy * int64_t(step), 0, height - 1);
+
+						const seeds& s = front[sy * width + sx];
+						if (s.inside[0] >= 0.f) {
+							if (float dst = distance(here, s.inside); dst < lowest_inside) {
+								lowest_inside = dst;
+								std::copy_n(s.inside, 2, out.inside);
+							}
+						}
+						if (s.outside[0] >= 0.f) {
+							if (float dst = distance(here, s.outside); dst < lowest_outside) {
+								lowest_outside = dst;
+								std::copy_n(s.outside, 2, out.outside);
+							}
+						}
+					}
+				}
+				back[y * width + x] = out;
+			}
+		}
+		front.swap(back);
+	};
+	uint32_t step = 1;
+	while ((step << 1) < std::max(width, height)) {
+		step <<= 1;
+	}
+	for (; step > 0; step >>= 1) {
+		jump(step);
+	}
+	jump(1);
+
+	// Resolve
+	field result{width, height, std::vector<float>(width * height, 0.f), std::vector<float>(width * height, 0.f)};
+	for (std::size_t y = 0; y < height; y++) {
+		for (std::size_t x = 0; x < width; x++) {
+			const seeds& s   = front[y * width + x];
+			std::size_t  idx = y * width + x;
+			float        here[2];
+			uv_of(x, y, here);
+			if (mask[idx]) {
+				result.inside[idx] =
+					(s.outside[0] >= 0.f) ? distance(here, s.outside) : std::numeric_limits<float>::infinity();
+			} else {
+				result.outside[idx] =
+					(s.inside[0] >= 0.f) ? distance(here, s.inside) : std::numeric_limits<float>::infinity();
+			}
+		}
+	}
+	return result;
+}
+
+//--------------------------------------------------------------------------------//
+// Shapes
+//--------------------------------------------------------------------------------//
+
+static mask_t shape(std::size_t width, std::size_t height, std::function<bool(float, float)> inside)
+{
+	mask_t mask(width * height);
+	for (std::size_t y = 0; y < height; y++) {
+		for (std::size_t x = 0; x < width; x++) {
+			float u = (static_cast<float>(x) + .5f) / width;
+			float v = (static_cast<float>(y) + .5f) / height;
+
+			mask[y * width + x] = inside(u, v) ? 1 : 0;
+		}
+	}
+	return mask;
+}
+
+static mask_t blobs(std::size_t width, std::size_t height, uint32_t seed, std::size_t count)
+{
+	std::mt19937                          rng(seed);
+	std::uniform_real_distribution<float> pos(0.f, 1.f);
+	std::uniform_real_distribution<float> radius(.005f, .08f);
+	std::vector<std::array<float, 3>>     circles(count);
+	for (auto& circle : circles) {
+		circle = {pos(rng), pos(rng), radius(rng)};
+	}
+
+	float aspect = static_cast<float>(width) / static_cast<float>(height);
+	return shape(width, height, [&circles, aspect](float u, float v) {
+		for (auto& circle : circles) {
+			float dx = (u - circle[0]) * aspect, dy = v - circle[1];
+			if ((dx * dx + dy * dy) < (circle[2] * circle[2])) {
+				return true;
+			}
+		}
+		return false;
+	});
+}
+
+int main(int argc, const char* argv[])
+{
+	std::size_t width  = 512;
+	std::size_t height = 288;
+	if (argc > 2) {
+		width  = std::max<std::size_t>(static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)), 1);
+		height = std::max<std::size_t>(static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10)), 1);
+	}
+
+	struct test {
+		const char* name;
+		mask_t      mask;
+	};
+	std::vector<test> tests = {
+		{"Disc", shape(width, height, [](float u, float v) { return std::hypot(u - .5f, v - .5f) < .3f; })},
+		{"Ring", shape(width, height,
+					   [](float u, float v) {
+						   float r = std::hypot(u - .5f, v - .5f);
+						   return (r < .4f) && (r > .3f);
+					   })},
+		{"Rectangles", shape(width, height,
+							 [](float u, float v) {
+								 return ((u > .1f) && (u < .3f) && (v > .2f) && (v < .9f))
+										|| ((u > .5f) && (u < .95f) && (v > .05f) && (v < .4f));
+							 })},
+		{"Thin Lines", shape(width, height,
+							 [width](float u, float) { return (static_cast<std::size_t>(u * width) % 37) == 0; })},
+		{"Single Texel", shape(width, height,
+							   [width, height](float u, float v) {
+								   return (static_cast<std::size_t>(u * width) == width / 3)
+										  && (static_cast<std::size_t>(v * height) == height / 5);
+							   })},
+		{"Blobs (Few)", blobs(width, height, 1, 8)},
+		{"Blobs (Many)", blobs(width, height, 2, 200)},
+	};
+
+	bool passed = true;
+	std::printf("%zux%zu, tolerance %.2f texels\n", width, height, TOLERANCE);
+	std::printf("%-16s %10s %10s %10s %10s %10s %s\n", "Shape", "JFA (ms)", "EDT (ms)", "Max Error", "Mean Error",
+				"Off Texels", "Result");
+	for (auto& t : tests) {
+		auto  t0  = std::chrono::high_resolution_clock::now();
+		field jfa = jump_flooding(t.mask, width, height);
+		auto  t1  = std::chrono::high_resolution_clock::now();
+		field ref = reference(t.mask, width, height);
+		auto  t2  = std::chrono::high_resolution_clock::now();
+
+		double      max_error = 0., sum_error = 0.;
+		std::size_t off = 0;
+		for (std::size_t idx = 0; idx < t.mask.size(); idx++) {
+			for (auto pair : {std::make_pair(jfa.inside[idx], ref.inside[idx]),
+							  std::make_pair(jfa.outside[idx], ref.outside[idx])}) {
+				// Both agree on there being nothing to find, which happens for shapes without inside or outside.
+				if (std::isinf(pair.first) && std::isinf(pair.second)) {
+					continue;
+				}
+				double error = std::abs(static_cast<double>(pair.first) - static_cast<double>(pair.second));
+				max_error    = std::max(max_error, error);
+				sum_error += error;
+				if (error > 1e-3) {
+					off++;
+				}
+			}
+		}
+
+		bool ok = (max_error <= TOLERANCE);
+		passed &= ok;
+		std::printf("%-16s %10.3f %10.3f %10.4f %10.6f %10zu %s\n", t.name,
+					std::chrono::duration<double, std::milli>(t1 - t0).count(),
+					std::chrono::duration<double, std::milli>(t2 - t1).count(), max_error,
+					sum_error / static_cast<double>(t.mask.size()), off, ok ? "Pass" : "FAIL");
+	}
+
+	return passed ? 0 : 1;
+}
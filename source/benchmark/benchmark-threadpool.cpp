@@ -0,0 +1,81 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Measures task throughput of util::threadpool while several threads push tiny tasks at the same time. Run it with
+// no arguments for the full sweep, or pass a task count to change the amount of work per measurement.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "util/util-threadpool.hpp"
+
+static double_t measure(std::size_t workers, std::size_t producers, std::size_t tasks)
+{
+	util::threadpool         pool(workers);
+	std::atomic<std::size_t> done{0};
+	auto                     fn = [&done](util::threadpool_data_t) { done.fetch_add(1, std::memory_order_relaxed); };
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<std::thread> threads;
+		for (std::size_t p = 0; p < producers; p++) {
+			threads.emplace_back([&pool, &fn, producers, tasks, p]() {
+				// Alternate between lanes so that both are under pressure.
+				for (std::size_t n = p; n < tasks; n += producers) {
+					pool.push(fn, nullptr,
+							  (n & 1) ? util::threadpool_priority::Background : util::threadpool_priority::Realtime);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+	while (done.load() < tasks) {
+		std::this_thread::yield();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return static_cast<double_t>(tasks) / std::chrono::duration<double_t>(end - begin).count();
+}
+
+int main(int argc, const char* argv[])
+{
+	std::size_t tasks = 1000000;
+	if (argc > 1) {
+		tasks = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+	}
+
+	std::size_t cores = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+	std::printf("%8s %10s %16s\n", "Workers", "Producers", "Tasks/s");
+	for (std::size_t workers = 1; workers <= cores * 2; workers *= 2) {
+		for (std::size_t producers = 1; producers <= cores; producers *= 2) {
+			std::printf("%8zu %10zu %16.0f\n", workers, producers, measure(workers, producers, tasks));
+		}
+	}
+
+	return 0;
+}
@@ -89,7 +89,12 @@ ffmpeg_instance::ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool
 
 	  _lag_in_frames(0), _sent_frames(0), _have_first_frame(false), _extra_data(), _sei_data(),
 
-	  _free_frames(), _used_frames(), _free_frames_last_used()
+	  _free_frames(), _used_frames(), _free_frames_last_used(),
+
+	  _profile_convert(util::profiler::get(std::string("encoder.") + _codec->name + ".convert")),
+	  _profile_copy(util::profiler::get(std::string("encoder.") + _codec->name + ".copy")),
+	  _profile_send(util::profiler::get(std::string("encoder.") + _codec->name + ".send")),
+	  _profile_receive(util::profiler::get(std::string("encoder.") + _codec->name + ".receive"))
 {
 	// Initialize GPU Stuff
 	if (is_hw) {
@@ -345,6 +350,8 @@ bool ffmpeg_instance::encode_video(struct encoder_frame* frame, struct encoder_p
 
 	// Convert frame.
 	{
+		util::profiler::instance profile{_profile_convert};
+
 		vframe->height          = _context->height;
 		vframe->format          = _context->pix_fmt;
 		vframe->color_range     = _context->color_range;
@@ -385,7 +392,10 @@ bool ffmpeg_instance::encode_video(uint32_t handle, int64_t pts, uint64_t lock_k
 	}
 
 	std::shared_ptr<AVFrame> vframe = pop_free_frame();
-	_hwinst->copy_from_obs(_context->hw_frames_ctx, handle, lock_key, next_key, vframe);
+	{
+		util::profiler::instance profile{_profile_copy};
+		_hwinst->copy_from_obs(_context->hw_frames_ctx, handle, lock_key, next_key, vframe);
+	}
 
 	vframe->color_range     = _context->color_range;
 	vframe->colorspace      = _context->colorspace;
@@ -600,8 +610,9 @@ int ffmpeg_instance::receive_packet(bool* received_packet, struct encoder_packet
 	av_packet_unref(&_packet);
 
 	{
-		auto gctx = gs::context();
-		res       = avcodec_receive_packet(_context, &_packet);
+		util::profiler::instance profile{_profile_receive};
+		auto                     gctx = gs::context();
+		res                           = avcodec_receive_packet(_context, &_packet);
 	}
 	if (res != 0) {
 		return res;
@@ -665,8 +676,9 @@ int ffmpeg_instance::send_frame(std::shared_ptr<AVFrame> const frame)
 {
 	int res = 0;
 	{
-		auto gctx = gs::context();
-		res       = avcodec_send_frame(_context, frame.get());
+		util::profiler::instance profile{_profile_send};
+		auto                     gctx = gs::context();
+		res                           = avcodec_send_frame(_context, frame.get());
 	}
 	if (res == 0) {
 		push_used_frame(frame);
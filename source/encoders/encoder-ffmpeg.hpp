@@ -76,6 +76,12 @@ namespace streamfx::encoder::ffmpeg {
 		std::queue<std::shared_ptr<AVFrame>>           _used_frames;
 		std::chrono::high_resolution_clock::time_point _free_frames_last_used;
 
+		// Profiling
+		std::shared_ptr<util::profiler> _profile_convert;
+		std::shared_ptr<util::profiler> _profile_copy;
+		std::shared_ptr<util::profiler> _profile_send;
+		std::shared_ptr<util::profiler> _profile_receive;
+
 		public:
 		ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool is_hw);
 		virtual ~ffmpeg_instance();
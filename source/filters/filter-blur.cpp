@@ -29,7 +29,9 @@
 #include "gfx/blur/gfx-blur-dual-filtering.hpp"
 #include "gfx/blur/gfx-blur-gaussian-linear.hpp"
 #include "gfx/blur/gfx-blur-gaussian.hpp"
+#include "gfx/gfx-texture-loader.hpp"
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/obs-source-tracker.hpp"
 
 // OBS
@@ -107,15 +109,24 @@ blur_instance::blur_instance(obs_data_t* settings, obs_source_t* self)
 	{
 		auto gctx = gs::context();
 
-		// Create RenderTargets
-		this->_source_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		this->_output_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-
 		// Load Effects
 		{
 			char* file = obs_module_file("effects/mask.effect");
 			try {
 				_effect_mask = gs::effect::create(file);
+
+				// Resolve parameters once, as they are needed every frame.
+				_effect_mask_params.image_orig           = _effect_mask.get_parameter("image_orig");
+				_effect_mask_params.image_blur           = _effect_mask.get_parameter("image_blur");
+				_effect_mask_params.region_left          = _effect_mask.get_parameter("mask_region_left");
+				_effect_mask_params.region_right         = _effect_mask.get_parameter("mask_region_right");
+				_effect_mask_params.region_top           = _effect_mask.get_parameter("mask_region_top");
+				_effect_mask_params.region_bottom        = _effect_mask.get_parameter("mask_region_bottom");
+				_effect_mask_params.region_feather       = _effect_mask.get_parameter("mask_region_feather");
+				_effect_mask_params.region_feather_shift = _effect_mask.get_parameter("mask_region_feather_shift");
+				_effect_mask_params.image                = _effect_mask.get_parameter("mask_image");
+				_effect_mask_params.color                = _effect_mask.get_parameter("mask_color");
+				_effect_mask_params.multiplier           = _effect_mask.get_parameter("mask_multiplier");
 			} catch (std::runtime_error& ex) {
 				DLOG_ERROR("<filter-blur> Loading _effect '%s' failed with error(s): %s", file, ex.what());
 			}
@@ -129,66 +140,67 @@ blur_instance::blur_instance(obs_data_t* settings, obs_source_t* self)
 
 blur_instance::~blur_instance() {}
 
-bool blur_instance::apply_mask_parameters(gs::effect effect, gs_texture_t* original_texture,
-										  gs_texture_t* blurred_texture)
+bool blur_instance::apply_mask_parameters(gs_texture_t* original_texture, gs_texture_t* blurred_texture)
 {
-	if (effect.has_parameter("image_orig")) {
-		effect.get_parameter("image_orig").set_texture(original_texture);
+	auto& params = _effect_mask_params;
+
+	if (params.image_orig) {
+		params.image_orig.set_texture(original_texture);
 	}
-	if (effect.has_parameter("image_blur")) {
-		effect.get_parameter("image_blur").set_texture(blurred_texture);
+	if (params.image_blur) {
+		params.image_blur.set_texture(blurred_texture);
 	}
 
 	// Region
 	if (_mask.type == mask_type::Region) {
-		if (effect.has_parameter("mask_region_left")) {
-			effect.get_parameter("mask_region_left").set_float(_mask.region.left);
+		if (params.region_left) {
+			params.region_left.set_float(_mask.region.left);
 		}
-		if (effect.has_parameter("mask_region_right")) {
-			effect.get_parameter("mask_region_right").set_float(_mask.region.right);
+		if (params.region_right) {
+			params.region_right.set_float(_mask.region.right);
 		}
-		if (effect.has_parameter("mask_region_top")) {
-			effect.get_parameter("mask_region_top").set_float(_mask.region.top);
+		if (params.region_top) {
+			params.region_top.set_float(_mask.region.top);
 		}
-		if (effect.has_parameter("mask_region_bottom")) {
-			effect.get_parameter("mask_region_bottom").set_float(_mask.region.bottom);
+		if (params.region_bottom) {
+			params.region_bottom.set_float(_mask.region.bottom);
 		}
-		if (effect.has_parameter("mask_region_feather")) {
-			effect.get_parameter("mask_region_feather").set_float(_mask.region.feather);
+		if (params.region_feather) {
+			params.region_feather.set_float(_mask.region.feather);
 		}
-		if (effect.has_parameter("mask_region_feather_shift")) {
-			effect.get_parameter("mask_region_feather_shift").set_float(_mask.region.feather_shift);
+		if (params.region_feather_shift) {
+			params.region_feather_shift.set_float(_mask.region.feather_shift);
 		}
 	}
 
 	// Image
 	if (_mask.type == mask_type::Image) {
-		if (effect.has_parameter("mask_image")) {
+		if (params.image) {
 			if (_mask.image.texture) {
-				effect.get_parameter("mask_image").set_texture(_mask.image.texture);
+				params.image.set_texture(_mask.image.texture);
 			} else {
-				effect.get_parameter("mask_image").set_texture(nullptr);
+				params.image.set_texture(nullptr);
 			}
 		}
 	}
 
 	// Source
 	if (_mask.type == mask_type::Source) {
-		if (effect.has_parameter("mask_image")) {
+		if (params.image) {
 			if (_mask.source.texture) {
-				effect.get_parameter("mask_image").set_texture(_mask.source.texture);
+				params.image.set_texture(_mask.source.texture);
 			} else {
-				effect.get_parameter("mask_image").set_texture(nullptr);
+				params.image.set_texture(nullptr);
 			}
 		}
 	}
 
 	// Shared
-	if (effect.has_parameter("mask_color")) {
-		effect.get_parameter("mask_color").set_float4(_mask.color.r, _mask.color.g, _mask.color.b, _mask.color.a);
+	if (params.color) {
+		params.color.set_float4(_mask.color.r, _mask.color.g, _mask.color.b, _mask.color.a);
 	}
-	if (effect.has_parameter("mask_multiplier")) {
-		effect.get_parameter("mask_multiplier").set_float(_mask.multiplier);
+	if (params.multiplier) {
+		params.multiplier.set_float(_mask.multiplier);
 	}
 
 	return true;
@@ -326,14 +338,16 @@ void blur_instance::video_tick(float)
 
 	// Load Mask
 	if (_mask.type == mask_type::Image) {
-		if (_mask.image.path_old != _mask.image.path) {
-			try {
-				_mask.image.texture  = std::make_shared<gs::texture>(_mask.image.path);
-				_mask.image.path_old = _mask.image.path;
-			} catch (...) {
-				DLOG_ERROR("<filter-blur> Instance '%s' failed to load image '%s'.", obs_source_get_name(_self),
-						   _mask.image.path.c_str());
-			}
+		// Keep the previous image until the new one has been loaded in the background.
+		bool failed = false;
+		if (auto texture = gfx::texture_loader::get()->load(_mask.image.path, failed); texture) {
+			_mask.image.texture  = texture;
+			_mask.image.path_old = _mask.image.path;
+		} else if (failed && (_mask.image.path_old != _mask.image.path)) {
+			DLOG_ERROR("<filter-blur> Instance '%s' failed to load image '%s'.", obs_source_get_name(_self),
+					   _mask.image.path.c_str());
+			_mask.image.texture.reset();
+			_mask.image.path_old = _mask.image.path;
 		}
 	} else if (_mask.type == mask_type::Source) {
 		if (_mask.source.name_old != _mask.source.name) {
@@ -350,6 +364,12 @@ void blur_instance::video_tick(float)
 
 	_source_rendered = false;
 	_output_rendered = false;
+
+	// Return render targets to the pool, they are acquired again on the next render.
+	_source_texture.reset();
+	_source_rt.reset();
+	_output_texture.reset();
+	_output_rt.reset();
 }
 
 void blur_instance::video_render(gs_effect_t* effect)
@@ -366,19 +386,17 @@ void blur_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Blur '%s'", obs_source_get_name(_self)};
-#endif
 
 	if (!_source_rendered) {
 		// Source To Texture
 		{
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
 
 			if (obs_source_process_filter_begin(this->_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
 				{
+					this->_source_rt = gs::rendertarget_pool::get()->acquire(baseW, baseH, GS_RGBA);
+
 					auto op = this->_source_rt->render(baseW, baseH);
 
 					gs_blend_state_push();
@@ -423,9 +441,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 
 	if (!_output_rendered) {
 		{
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_convert, "Blur"};
-#endif
 
 			_blur->set_input(_source_texture);
 			_output_texture = _blur->render();
@@ -433,9 +449,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 
 		// Mask
 		if (_mask.enabled) {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_convert, "Mask"};
-#endif
 
 			gs_blend_state_push();
 			gs_reset_blend_state();
@@ -491,17 +505,17 @@ void blur_instance::video_render(gs_effect_t* effect)
 					}
 				}
 
-#ifdef ENABLE_PROFILING
 				gs::debug_marker gdm{gs::debug_color_capture, "Capture '%s'",
 									 obs_source_get_name(_mask.source.source_texture->get_object())};
-#endif
 
 				this->_mask.source.texture = this->_mask.source.source_texture->render(source_width, source_height);
 			}
 
-			apply_mask_parameters(_effect_mask, _source_texture->get_object(), _output_texture->get_object());
+			apply_mask_parameters(_source_texture->get_object(), _output_texture->get_object());
 
 			try {
+				this->_output_rt = gs::rendertarget_pool::get()->acquire(baseW, baseH, GS_RGBA);
+
 				auto op = this->_output_rt->render(baseW, baseH);
 				gs_ortho(0, 1, 0, 1, -1, 1);
 
@@ -523,13 +537,18 @@ void blur_instance::video_render(gs_effect_t* effect)
 		}
 
 		_output_rendered = true;
+
+		// The capture is only an intermediate for blurring, return it to the pool right away. It is kept if the blur
+		//  had nothing to do, as it is then drawn directly.
+		if (_output_texture != _source_texture) {
+			_source_texture.reset();
+			_source_rt.reset();
+		}
 	}
 
 	// Draw source
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		// It is important that we do not modify the blend state here, as it is set correctly by OBS
 		gs_set_cull_mode(GS_NEITHER);
@@ -875,13 +894,13 @@ obs_properties_t* blur_factory::get_properties2(blur_instance* data)
 				obs_property_list_add_string(p, std::string(name + " (Source)").c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_video_sources);
+			obs::source_tracker::source_kind::VideoInput);
 		obs::source_tracker::get()->enumerate(
 			[&p](std::string name, obs_source_t*) {
 				obs_property_list_add_string(p, std::string(name + " (Scene)").c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_scenes);
+			obs::source_tracker::source_kind::Scene);
 
 		/// Shared
 		p = obs_properties_add_color(pr, ST_MASK_COLOR, D_TRANSLATE(ST_MASK_COLOR));
@@ -41,6 +41,19 @@ namespace streamfx::filter::blur {
 	class blur_instance : public obs::source_instance {
 		// Effects
 		gs::effect _effect_mask;
+		struct {
+			gs::effect_parameter image_orig;
+			gs::effect_parameter image_blur;
+			gs::effect_parameter region_left;
+			gs::effect_parameter region_right;
+			gs::effect_parameter region_top;
+			gs::effect_parameter region_bottom;
+			gs::effect_parameter region_feather;
+			gs::effect_parameter region_feather_shift;
+			gs::effect_parameter image;
+			gs::effect_parameter color;
+			gs::effect_parameter multiplier;
+		} _effect_mask_params;
 
 		// Input
 		std::shared_ptr<gs::rendertarget> _source_rt;
@@ -107,7 +120,7 @@ namespace streamfx::filter::blur {
 		virtual void video_render(gs_effect_t* effect) override;
 
 		private:
-		bool apply_mask_parameters(gs::effect effect, gs_texture_t* original_texture, gs_texture_t* blurred_texture);
+		bool apply_mask_parameters(gs_texture_t* original_texture, gs_texture_t* blurred_texture);
 	};
 
 	class blur_factory : public obs::source_factory<filter::blur::blur_factory, filter::blur::blur_instance> {
@@ -21,6 +21,7 @@
 #include "strings.hpp"
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 
 // OBS
 #ifdef _MSC_VER
@@ -83,33 +84,12 @@ color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* self)
 	{
 		char* file = obs_module_file("effects/color-grade.effect");
 		if (file) {
-			try {
-				_effect = gs::effect::create(file);
-				bfree(file);
-			} catch (std::runtime_error& ex) {
-				DLOG_ERROR("<filter-color-grade> Loading _effect '%s' failed with error(s): %s", file, ex.what());
-				bfree(file);
-				throw ex;
-			}
+			_effects = std::make_shared<gs::effect_permutations>(file);
+			bfree(file);
 		} else {
 			throw std::runtime_error("Missing file color-grade.effect.");
 		}
 	}
-	{
-		_rt_source = std::make_unique<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		{
-			auto op = _rt_source->render(1, 1);
-		}
-		_tex_source = _rt_source->get_texture();
-	}
-	{
-		_rt_grade = std::make_unique<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		{
-			auto op = _rt_grade->render(1, 1);
-		}
-		_tex_grade = _rt_grade->get_texture();
-	}
-
 	update(data);
 }
 
@@ -163,12 +143,32 @@ void color_grade_instance::update(obs_data_t* data)
 	_correction.y   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(SATURATION)) / 100.0);
 	_correction.z   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(LIGHTNESS)) / 100.0);
 	_correction.w   = static_cast<float_t>(obs_data_get_double(data, ST_CORRECTION_(CONTRAST)) / 100.0);
+
+	// Compile detection and luma mode into the effect, instead of branching on them for every pixel. The variant is
+	//  picked on the graphics thread, which is the only one allowed to touch _effect.
+	auto defines = std::make_shared<const gs::effect::defines_t>(gs::effect::defines_t{
+		{"TINT_DETECTION", std::to_string(static_cast<int32_t>(_tint_detection))},
+		{"TINT_MODE", std::to_string(static_cast<int32_t>(_tint_luma))},
+	});
+	std::atomic_store(&_effect_defines, std::move(defines));
 }
 
 void color_grade_instance::video_tick(float)
 {
+	if (auto defines = std::atomic_exchange(&_effect_defines, {}); defines) {
+		try {
+			_effect = _effects->get(*defines);
+		} catch (const std::exception& ex) {
+			DLOG_ERROR("<filter-color-grade> Loading effect variant failed with error(s): %s", ex.what());
+		}
+	}
+
 	_source_updated = false;
 	_grade_updated  = false;
+
+	// Return the graded result to the pool, it is acquired again on the next render.
+	_tex_grade.reset();
+	_rt_grade.reset();
 }
 
 void color_grade_instance::video_render(gs_effect_t* effect)
@@ -181,21 +181,19 @@ void color_grade_instance::video_render(gs_effect_t* effect)
 	gs_effect_t*  effect_default = obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
 
 	// Skip filter if anything is wrong.
-	if (!parent || !target || !width || !height || !effect_default) {
+	if (!parent || !target || !width || !height || !effect_default || !_effect) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Color Grading '%s'", obs_source_get_name(_self)};
-#endif
 
 	if (!_source_updated) {
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
 
 		if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+			_rt_source = gs::rendertarget_pool::get()->acquire(width, height, GS_RGBA);
+
 			auto op = _rt_source->render(width, height);
 			gs_blend_state_push();
 			gs_reset_blend_state();
@@ -208,6 +206,9 @@ void color_grade_instance::video_render(gs_effect_t* effect)
 			gs_ortho(0, static_cast<float_t>(width), 0, static_cast<float_t>(height), -1., 1.);
 			obs_source_process_filter_end(_self, effect ? effect : effect_default, width, height);
 			gs_blend_state_pop();
+		} else {
+			obs_source_skip_video_filter(_self);
+			return;
 		}
 
 		_tex_source     = _rt_source->get_texture();
@@ -215,11 +216,11 @@ void color_grade_instance::video_render(gs_effect_t* effect)
 	}
 
 	if (!_grade_updated) {
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_convert, "Calculate"};
-#endif
 
 		{
+			_rt_grade = gs::rendertarget_pool::get()->acquire(width, height, GS_RGBA);
+
 			auto op = _rt_grade->render(width, height);
 			gs_blend_state_push();
 			gs_reset_blend_state();
@@ -251,15 +252,17 @@ void color_grade_instance::video_render(gs_effect_t* effect)
 			gs_blend_state_pop();
 		}
 
-		_tex_grade      = _rt_grade->get_texture();
-		_source_updated = true;
+		_tex_grade     = _rt_grade->get_texture();
+		_grade_updated = true;
+
+		// The source is only an intermediate for grading, return it to the pool right away.
+		_tex_source.reset();
+		_rt_source.reset();
 	}
 
 	// Render final result.
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		auto shader = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 		gs_enable_depth_test(false);
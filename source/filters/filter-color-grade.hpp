@@ -19,6 +19,7 @@
 
 #pragma once
 #include <vector>
+#include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-mipmapper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
@@ -42,15 +43,17 @@ namespace streamfx::filter::color_grade {
 	};
 
 	class color_grade_instance : public obs::source_instance {
-		gs::effect _effect;
+		std::shared_ptr<gs::effect_permutations>     _effects;
+		std::shared_ptr<const gs::effect::defines_t> _effect_defines; // Handed from update() to video_tick().
+		gs::effect                                   _effect;
 
 		// Source
-		std::unique_ptr<gs::rendertarget> _rt_source;
+		std::shared_ptr<gs::rendertarget> _rt_source;
 		std::shared_ptr<gs::texture>      _tex_source;
 		bool                              _source_updated;
 
 		// Grading
-		std::unique_ptr<gs::rendertarget> _rt_grade;
+		std::shared_ptr<gs::rendertarget> _rt_grade;
 		std::shared_ptr<gs::texture>      _tex_grade;
 		bool                              _grade_updated;
 
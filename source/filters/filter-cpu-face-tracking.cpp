@@ -0,0 +1,535 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "filter-cpu-face-tracking.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "obs/gs/gs-helper.hpp"
+#include "obs/obs-tools.hpp"
+
+#define ST "Filter.CPU.FaceTracking"
+#define ST_ROI "Filter.CPU.FaceTracking.ROI"
+#define ST_ROI_ZOOM "Filter.CPU.FaceTracking.ROI.Zoom"
+#define SK_ROI_ZOOM "ROI.Zoom"
+#define ST_ROI_OFFSET "Filter.CPU.FaceTracking.ROI.Offset"
+#define ST_ROI_OFFSET_X "Filter.CPU.FaceTracking.ROI.Offset.X"
+#define SK_ROI_OFFSET_X "ROI.Offset.X"
+#define ST_ROI_OFFSET_Y "Filter.CPU.FaceTracking.ROI.Offset.Y"
+#define SK_ROI_OFFSET_Y "ROI.Offset.Y"
+#define ST_ROI_STABILITY "Filter.CPU.FaceTracking.ROI.Stability"
+#define SK_ROI_STABILITY "ROI.Stability"
+#define ST_TRACKING "Filter.CPU.FaceTracking.Tracking"
+#define ST_TRACKING_RATE "Filter.CPU.FaceTracking.Tracking.Rate"
+#define SK_TRACKING_RATE "Tracking.Rate"
+
+// Height of the frame that is analyzed, larger frames are scaled down to this.
+#define ANALYSIS_HEIGHT 144
+
+// Analyses in a row without a face before returning to the full frame, bridges blinks and brief occlusions.
+#define ANALYSIS_MAX_MISSES 5
+
+using namespace streamfx::filter::cpu;
+
+face_tracking_instance::face_tracking_instance(obs_data_t* settings, obs_source_t* self)
+	: obs::source_instance(settings, self),
+
+	  _size(), _rt_is_fresh(false), _rt(),
+
+	  _cfg_zoom(1.0), _cfg_offset({0., 0.}), _cfg_stability(1.0), _cfg_rate(3),
+
+	  _geometry(), _filters(), _values(),
+
+	  _frame(0), _readback(), _analysis_mask(), _analysis_stack(), _analysis_misses(0),
+	  _async_group(std::make_shared<util::threadpool_group>())
+{
+	{ // Create render target, vertex buffer and readback ring.
+		auto gctx = gs::context{};
+		_rt       = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+		_geometry = std::make_shared<gs::vertex_buffer>(uint32_t(4), uint8_t(1));
+		_readback = std::make_shared<gs::readback>(GS_RGBA, 2);
+	}
+
+	{ // Set up initial tracking data.
+		_values.center[0] = _values.center[1] = .5;
+		_values.size[0] = _values.size[1] = 1.;
+		_values.velocity[0] = _values.velocity[1] = 0.;
+		refresh_region_of_interest();
+	}
+}
+
+face_tracking_instance::~face_tracking_instance()
+{
+	// Kill pending tasks, anything already running bails out once it fails to acquire the source.
+	_async_group->cancel();
+
+	auto gctx = gs::context{};
+	_readback.reset();
+	_rt.reset();
+	_geometry.reset();
+}
+
+struct async_track_data {
+	std::shared_ptr<obs_weak_source_t>   source;
+	std::shared_ptr<gs::readback::frame> frame;
+};
+
+void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
+{
+	// Try and acquire a strong source reference.
+	std::shared_ptr<async_track_data> data = std::static_pointer_cast<async_track_data>(ptr);
+	std::shared_ptr<obs_source_t>     remote_work =
+		std::shared_ptr<obs_source_t>(obs_weak_source_get_source(data->source.get()), obs::obs_source_deleter);
+	if (!remote_work) { // If that failed, the source we are working for was deleted - abort now.
+		return;
+	}
+
+	const std::vector<uint8_t>& image  = data->frame->data;
+	std::size_t                 width  = data->frame->width;
+	std::size_t                 height = data->frame->height;
+	std::size_t                 pitch  = data->frame->pitch;
+	if ((width == 0) || (height == 0) || (pitch < (width * 4))) {
+		return;
+	}
+
+	// Classify skin colored pixels, using the Cb/Cr ranges from Chai & Ngan in integer BT.601 YCbCr.
+	_analysis_mask.resize(width * height);
+	for (std::size_t idx = 0, end = width * height; idx < end; idx++) {
+		const uint8_t* px = &image[(idx / width) * pitch + (idx % width) * 4];
+		int32_t        r  = px[0];
+		int32_t        g  = px[1];
+		int32_t        b  = px[2];
+		int32_t        y  = (77 * r + 150 * g + 29 * b) >> 8;
+		int32_t        cb = ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+		int32_t        cr = ((128 * r - 107 * g - 21 * b) >> 8) + 128;
+
+		_analysis_mask[idx] = ((y > 40) && (cb >= 77) && (cb <= 127) && (cr >= 133) && (cr <= 173)) ? 1 : 0;
+	}
+
+	// Where was the face last time? Regions close to it are preferred, which keeps hands and similar regions from
+	// stealing focus.
+	double_t last_x;
+	double_t last_y;
+	{
+		std::unique_lock<std::mutex> tlk{_values.lock};
+		last_x = _values.center[0] * static_cast<double_t>(width);
+		last_y = _values.center[1] * static_cast<double_t>(height);
+	}
+
+	// Find the best connected region of skin colored pixels.
+	struct {
+		double_t    score = 0.;
+		std::size_t area  = 0;
+		std::size_t x0, y0, x1, y1;
+	} best;
+	std::size_t min_area = std::max<std::size_t>((width * height) / 500, 16);
+	for (std::size_t seed = 0, end = width * height; seed < end; seed++) {
+		if (_analysis_mask[seed] != 1)
+			continue;
+
+		// Flood fill the region, marking everything visited.
+		std::size_t area = 0;
+		std::size_t x0 = width, y0 = height, x1 = 0, y1 = 0;
+		_analysis_mask[seed] = 2;
+		_analysis_stack.clear();
+		_analysis_stack.push_back(static_cast<uint32_t>(seed));
+		while (!_analysis_stack.empty()) {
+			std::size_t idx = _analysis_stack.back();
+			_analysis_stack.pop_back();
+
+			std::size_t x = idx % width;
+			std::size_t y = idx / width;
+			x0            = std::min(x0, x);
+			y0            = std::min(y0, y);
+			x1            = std::max(x1, x);
+			y1            = std::max(y1, y);
+			area++;
+
+			auto visit = [this](std::size_t next) {
+				if (_analysis_mask[next] == 1) {
+					_analysis_mask[next] = 2;
+					_analysis_stack.push_back(static_cast<uint32_t>(next));
+				}
+			};
+			if (x > 0)
+				visit(idx - 1);
+			if (x + 1 < width)
+				visit(idx + 1);
+			if (y > 0)
+				visit(idx - width);
+			if (y + 1 < height)
+				visit(idx + width);
+		}
+
+		if (area < min_area)
+			continue;
+
+		// Faces are roughly elliptical and taller than wide, reject anything that does not fit that.
+		double_t bw     = static_cast<double_t>(x1 - x0 + 1);
+		double_t bh     = static_cast<double_t>(y1 - y0 + 1);
+		double_t fill   = static_cast<double_t>(area) / (bw * bh);
+		double_t aspect = bh / bw;
+		if ((fill < 0.4) || (aspect < 0.6) || (aspect > 2.5))
+			continue;
+
+		double_t dx    = ((x0 + x1 + 1) / 2. - last_x) / static_cast<double_t>(width);
+		double_t dy    = ((y0 + y1 + 1) / 2. - last_y) / static_cast<double_t>(height);
+		double_t score = static_cast<double_t>(area) * fill / (1. + 4. * std::sqrt(dx * dx + dy * dy));
+		if (score > best.score) {
+			best.score = score;
+			best.area  = area;
+			best.x0    = x0;
+			best.y0    = y0;
+			best.x1    = x1;
+			best.y1    = y1;
+		}
+	}
+
+	// Only one analysis runs at a time, so the miss counter needs no lock of its own.
+	if (best.area == 0) {
+		if (++_analysis_misses <= ANALYSIS_MAX_MISSES) {
+			// Hold the last region, the face is likely still there.
+			std::unique_lock<std::mutex> tlk{_values.lock};
+			_values.velocity[0] = 0;
+			_values.velocity[1] = 0;
+			return;
+		}
+
+		// Nothing found for too long, return to full frame.
+		std::unique_lock<std::mutex> tlk{_values.lock};
+		_values.center[0]   = .5;
+		_values.center[1]   = .5;
+		_values.size[0]     = 1.;
+		_values.size[1]     = 1.;
+		_values.velocity[0] = 0;
+		_values.velocity[1] = 0;
+		return;
+	}
+	_analysis_misses = 0;
+
+	double_t sx     = static_cast<double_t>(width);
+	double_t sy     = static_cast<double_t>(height);
+	double_t aspect = sx / sy;
+	double_t fps    = 0.;
+
+	{
+		obs_video_info ovi;
+		obs_get_video_info(&ovi);
+		fps = static_cast<double_t>(ovi.fps_num) / static_cast<double_t>(ovi.fps_den);
+	}
+
+	// Store values and center.
+	double_t fsx = static_cast<double_t>(best.x1 - best.x0 + 1);
+	double_t fsy = static_cast<double_t>(best.y1 - best.y0 + 1);
+	double_t bsx = fsx;
+	double_t bsy = fsy;
+	double_t bcx = best.x0 + bsx / 2.0;
+	double_t bcy = best.y0 + bsy / 2.0;
+
+	// Zoom, Aspect Ratio, Offset
+	bsy = util::math::lerp<double_t>(sy, bsy, _cfg_zoom);
+	bsy = std::clamp(bsy, std::min(10 * aspect, sy), sy);
+	bsx = bsy * aspect;
+	bcx += fsx * _cfg_offset.first;
+	bcy += fsy * _cfg_offset.second;
+
+	// Fit back into the frame, see the NVIDIA filter for why only the center needs adjusting.
+	bcx = std::clamp(bcx, (bsx / 2.), sx - (bsx / 2.));
+	bcy = std::clamp(bcy, (bsy / 2.), sy - (bsy / 2.));
+
+	{ // Update target values.
+		std::unique_lock<std::mutex> tlk{_values.lock};
+		_values.velocity[0] = -_values.center[0];
+		_values.velocity[1] = -_values.center[1];
+		_values.center[0]   = bcx / sx;
+		_values.center[1]   = bcy / sy;
+		_values.velocity[0] += _values.center[0];
+		_values.velocity[1] += _values.center[1];
+		_values.velocity[0] *= fps / static_cast<double_t>(_cfg_rate);
+		_values.velocity[1] *= fps / static_cast<double_t>(_cfg_rate);
+		_values.size[0] = bsx / sx;
+		_values.size[1] = bsy / sy;
+	}
+}
+
+void face_tracking_instance::refresh_geometry()
+{ // Update Region of Interest Geometry.
+	auto v0 = _geometry->at(0);
+	auto v1 = _geometry->at(1);
+	auto v2 = _geometry->at(2);
+	auto v3 = _geometry->at(3);
+
+	vec3_set(v3.position, static_cast<float_t>(_size.first), static_cast<float_t>(_size.second), 0.);
+	vec3_set(v2.position, v3.position->x, 0., 0.);
+	vec3_set(v1.position, 0., v3.position->y, 0.);
+	vec3_set(v0.position, 0., 0., 0.);
+
+	float_t hsx = static_cast<float_t>(_filters.size[0].get() / 2.);
+	float_t hsy = static_cast<float_t>(_filters.size[1].get() / 2.);
+	vec4_set(v0.uv[0], static_cast<float_t>(_filters.center[0].get() - hsx),
+			 static_cast<float_t>(_filters.center[1].get() - hsy), 0., 0.);
+	vec4_set(v1.uv[0], static_cast<float_t>(_filters.center[0].get() - hsx),
+			 static_cast<float_t>(_filters.center[1].get() + hsy), 0., 0.);
+	vec4_set(v2.uv[0], static_cast<float_t>(_filters.center[0].get() + hsx),
+			 static_cast<float_t>(_filters.center[1].get() - hsy), 0., 0.);
+	vec4_set(v3.uv[0], static_cast<float_t>(_filters.center[0].get() + hsx),
+			 static_cast<float_t>(_filters.center[1].get() + hsy), 0., 0.);
+
+	_geometry->update(true);
+}
+
+void face_tracking_instance::refresh_region_of_interest()
+{
+	std::unique_lock<std::mutex> tlk(_values.lock);
+
+	double_t kalman_q = util::math::lerp<double_t>(1.0, 1e-6, _cfg_stability);
+	double_t kalman_r = util::math::lerp<double_t>(std::numeric_limits<double_t>::epsilon(), 1e+2, _cfg_stability);
+
+	_filters.center[0] = util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _values.center[0]};
+	_filters.center[1] = util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _values.center[1]};
+	_filters.size[0]   = util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _values.size[0]};
+	_filters.size[1]   = util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _values.size[1]};
+}
+
+void face_tracking_instance::load(obs_data_t* data)
+{
+	update(data);
+}
+
+void face_tracking_instance::migrate(obs_data_t* data, uint64_t version) {}
+
+void face_tracking_instance::update(obs_data_t* data)
+{
+	_cfg_zoom          = obs_data_get_double(data, SK_ROI_ZOOM) / 100.0;
+	_cfg_offset.first  = obs_data_get_double(data, SK_ROI_OFFSET_X) / 100.0;
+	_cfg_offset.second = obs_data_get_double(data, SK_ROI_OFFSET_Y) / 100.0;
+	_cfg_stability     = obs_data_get_double(data, SK_ROI_STABILITY) / 100.0;
+	_cfg_rate          = static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(data, SK_TRACKING_RATE), 1, 60));
+
+	// Refresh the Region Of Interest
+	refresh_region_of_interest();
+}
+
+void face_tracking_instance::video_tick(float_t seconds)
+{
+	// Update the input size.
+	if (obs_source_t* src = obs_filter_get_target(_self); src != nullptr) {
+		_size.first  = obs_source_get_base_width(src);
+		_size.second = obs_source_get_base_height(src);
+	}
+
+	// Update filters and geometry
+	{
+		std::unique_lock<std::mutex> tlk(_values.lock);
+		_filters.center[0].filter(_values.center[0]);
+		_filters.center[1].filter(_values.center[1]);
+		_filters.size[0].filter(_values.size[0]);
+		_filters.size[1].filter(_values.size[1]);
+		_values.center[0] += _values.velocity[0] * seconds;
+		_values.center[1] += _values.velocity[1] * seconds;
+	}
+	refresh_geometry();
+
+	_frame++;
+	_rt_is_fresh = false;
+}
+
+void face_tracking_instance::video_render(gs_effect_t* effect)
+{
+	obs_source_t* filter_parent  = obs_filter_get_parent(_self);
+	obs_source_t* filter_target  = obs_filter_get_target(_self);
+	gs_effect_t*  default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+
+	if (!filter_parent || !filter_target || !_size.first || !_size.second) {
+		obs_source_skip_video_filter(_self);
+		return;
+	}
+
+	gs::debug_marker gdmp{gs::debug_color_source, "CPU Face Tracking '%s'...", obs_source_get_name(_self)};
+	gs::debug_marker gdmp2{gs::debug_color_source, "... on '%s'", obs_source_get_name(obs_filter_get_parent(_self))};
+
+	if (!_rt_is_fresh) { // Capture the filter stack "below" us.
+		{
+			gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
+
+			if (obs_source_process_filter_begin(_self, _rt->get_color_format(), OBS_ALLOW_DIRECT_RENDERING)) {
+				auto op  = _rt->render(_size.first, _size.second);
+				vec4 clr = {0., 0., 0., 0.};
+
+				gs_ortho(0., 1., 0., 1., -1., 1.);
+				gs_clear(GS_CLEAR_COLOR, &clr, 0., 0);
+				gs_enable_color(true, true, true, true);
+				gs_enable_blending(false);
+
+				obs_source_process_filter_tech_end(_self, default_effect, 1, 1, "Draw");
+			} else {
+				obs_source_skip_video_filter(_self);
+				return;
+			}
+		}
+
+		// Hand off the last frame for analysis, and maybe stage a new one.
+		stage_analysis();
+
+		_rt_is_fresh = true;
+	}
+
+	{ // Draw Texture
+		gs::debug_marker gdm{gs::debug_color_render, "Render"};
+
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect ? effect : default_effect, "image"),
+							  _rt->get_texture()->get_object());
+		gs_load_vertexbuffer(_geometry->update(false));
+		while (gs_effect_loop(effect ? effect : default_effect, "Draw")) {
+			gs_draw(gs_draw_mode::GS_TRISTRIP, 0, 0);
+		}
+		gs_load_vertexbuffer(nullptr);
+	}
+}
+
+void face_tracking_instance::stage_analysis()
+{
+	// Hand the oldest finished copy to the threadpool, but only run one analysis at a time.
+	if (_async_group->pending() == 0) {
+		if (auto frame = _readback->read(); frame) {
+			auto data    = std::make_shared<async_track_data>();
+			data->source = std::shared_ptr<obs_weak_source_t>(obs_source_get_weak_source(_self),
+															  obs::obs_weak_source_deleter);
+			data->frame  = frame;
+
+			// Analysis is allowed to lag behind, it must never take time away from real-time work.
+			util::threadpool_options options;
+			options.priority = util::threadpool_priority::Background;
+			options.group    = _async_group;
+			streamfx::threadpool()->push(std::bind(&face_tracking_instance::async_track, this, std::placeholders::_1),
+										 data, options);
+		}
+	}
+
+	if ((_frame % _cfg_rate) != 0) {
+		return;
+	}
+
+	// Scale down while staging, and prefer the newest frame over ones the analysis had no time for.
+	uint32_t height = std::min<uint32_t>(_size.second, ANALYSIS_HEIGHT);
+	uint32_t width  = std::max<uint32_t>(static_cast<uint32_t>(uint64_t(_size.first) * height / _size.second), 1);
+	if (!_readback->stage(_rt->get_object(), width, height)) {
+		_readback->clear();
+		_readback->stage(_rt->get_object(), width, height);
+	}
+}
+
+face_tracking_factory::face_tracking_factory()
+{
+	// Info
+	_info.id           = PREFIX "filter-cpu-face-tracking";
+	_info.type         = OBS_SOURCE_TYPE_FILTER;
+	_info.output_flags = OBS_SOURCE_VIDEO;
+
+	set_resolution_enabled(false);
+	finish_setup();
+	register_proxy("streamfx-cpu-face-tracking");
+}
+
+face_tracking_factory::~face_tracking_factory() {}
+
+const char* face_tracking_factory::get_name()
+{
+	return D_TRANSLATE(ST);
+}
+
+void face_tracking_factory::get_defaults2(obs_data_t* data)
+{
+	obs_data_set_default_double(data, SK_ROI_ZOOM, 50.0);
+	obs_data_set_default_double(data, SK_ROI_OFFSET_X, 0.0);
+	obs_data_set_default_double(data, SK_ROI_OFFSET_Y, -15.0);
+	obs_data_set_default_double(data, SK_ROI_STABILITY, 50.0);
+	obs_data_set_default_int(data, SK_TRACKING_RATE, 3);
+}
+
+obs_properties_t* face_tracking_factory::get_properties2(face_tracking_instance* data)
+{
+	obs_properties_t* pr = obs_properties_create();
+
+	{
+		auto grp = obs_properties_create();
+		obs_properties_add_group(pr, ST_ROI, D_TRANSLATE(ST_ROI), OBS_GROUP_NORMAL, grp);
+		{
+			auto p =
+				obs_properties_add_float_slider(grp, SK_ROI_STABILITY, D_TRANSLATE(ST_ROI_STABILITY), 0, 100.0, 0.01);
+			obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_ROI_STABILITY)));
+			obs_property_float_set_suffix(p, " %");
+		}
+		{
+			auto p = obs_properties_add_float_slider(grp, SK_ROI_ZOOM, D_TRANSLATE(ST_ROI_ZOOM), 0, 200.0, 0.01);
+			obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_ROI_ZOOM)));
+			obs_property_float_set_suffix(p, " %");
+		}
+		{
+			auto grp2 = obs_properties_create();
+			obs_properties_add_group(grp, ST_ROI_OFFSET, D_TRANSLATE(ST_ROI_OFFSET), OBS_GROUP_NORMAL, grp2);
+
+			{
+				auto p = obs_properties_add_float_slider(grp2, SK_ROI_OFFSET_X, D_TRANSLATE(ST_ROI_OFFSET_X), -50.0,
+														 50.0, 0.01);
+				obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_ROI_OFFSET_X)));
+				obs_property_float_set_suffix(p, " %");
+			}
+			{
+				auto p = obs_properties_add_float_slider(grp2, SK_ROI_OFFSET_Y, D_TRANSLATE(ST_ROI_OFFSET_Y), -50.0,
+														 50.0, 0.01);
+				obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_ROI_OFFSET_Y)));
+				obs_property_float_set_suffix(p, " %");
+			}
+		}
+	}
+
+	{
+		auto grp = obs_properties_create();
+		obs_properties_add_group(pr, ST_TRACKING, D_TRANSLATE(ST_TRACKING), OBS_GROUP_NORMAL, grp);
+		{
+			auto p = obs_properties_add_int_slider(grp, SK_TRACKING_RATE, D_TRANSLATE(ST_TRACKING_RATE), 1, 60, 1);
+			obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_TRACKING_RATE)));
+			obs_property_int_set_suffix(p, " frames");
+		}
+	}
+
+	return pr;
+}
+
+std::shared_ptr<face_tracking_factory> _filter_cpu_face_tracking_factory_instance = nullptr;
+
+void streamfx::filter::cpu::face_tracking_factory::initialize()
+{
+	try {
+		_filter_cpu_face_tracking_factory_instance = std::make_shared<filter::cpu::face_tracking_factory>();
+	} catch (const std::exception& ex) {
+		DLOG_ERROR("<CPU Face Tracking Filter> %s", ex.what());
+	}
+}
+
+void streamfx::filter::cpu::face_tracking_factory::finalize()
+{
+	_filter_cpu_face_tracking_factory_instance.reset();
+}
+
+std::shared_ptr<face_tracking_factory> streamfx::filter::cpu::face_tracking_factory::get()
+{
+	return _filter_cpu_face_tracking_factory_instance;
+}
@@ -0,0 +1,113 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <mutex>
+#include <vector>
+#include "obs/gs/gs-readback.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-vertexbuffer.hpp"
+#include "obs/obs-source-factory.hpp"
+
+namespace streamfx::filter::cpu {
+	/** Face and region tracking without any GPU compute or vendor SDK.
+	 *
+	 * A small downscaled copy of the input is read back every few frames through gs::readback, and searched for the
+	 * most likely face region on the threadpool. The result drives the same region of interest logic as the NVIDIA
+	 * filter.
+	 */
+	class face_tracking_instance : public obs::source_instance {
+		// Filter Cache
+		std::pair<uint32_t, uint32_t>     _size;
+		bool                              _rt_is_fresh;
+		std::shared_ptr<gs::rendertarget> _rt;
+
+		// Settings
+		double_t                      _cfg_zoom;
+		std::pair<double_t, double_t> _cfg_offset;
+		double_t                      _cfg_stability;
+		uint32_t                      _cfg_rate;
+
+		// Operational Data
+		std::shared_ptr<gs::vertex_buffer> _geometry;
+		struct {
+			util::math::kalman1D<double_t> center[2];
+			util::math::kalman1D<double_t> size[2];
+		} _filters;
+		struct {
+			std::mutex lock;
+			double_t   center[2];
+			double_t   size[2];
+			double_t   velocity[2];
+		} _values;
+
+		// Analysis
+		uint64_t                                _frame;
+		std::shared_ptr<gs::readback>           _readback;
+		std::vector<uint8_t>                    _analysis_mask;
+		std::vector<uint32_t>                   _analysis_stack;
+		uint32_t                                _analysis_misses;
+		std::shared_ptr<util::threadpool_group> _async_group;
+
+		public:
+		face_tracking_instance(obs_data_t*, obs_source_t*);
+		virtual ~face_tracking_instance() override;
+
+		// Tasks
+		void async_track(std::shared_ptr<void> data);
+
+		void refresh_geometry();
+
+		void refresh_region_of_interest();
+
+		virtual void load(obs_data_t* data) override;
+
+		virtual void migrate(obs_data_t* data, uint64_t version) override;
+
+		virtual void update(obs_data_t* data) override;
+
+		virtual void video_tick(float_t seconds) override;
+
+		virtual void video_render(gs_effect_t* effect) override;
+
+		private:
+		void stage_analysis();
+	};
+
+	class face_tracking_factory
+		: public obs::source_factory<filter::cpu::face_tracking_factory, filter::cpu::face_tracking_instance> {
+		public:
+		face_tracking_factory();
+		virtual ~face_tracking_factory() override;
+
+		virtual const char* get_name() override;
+
+		virtual void get_defaults2(obs_data_t* data) override;
+
+		virtual obs_properties_t* get_properties2(filter::cpu::face_tracking_instance* data) override;
+
+		public: // Singleton
+		static void initialize();
+
+		static void finalize();
+
+		static std::shared_ptr<face_tracking_factory> get();
+	};
+} // namespace streamfx::filter::cpu
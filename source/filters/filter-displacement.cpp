@@ -21,6 +21,7 @@
 #include "strings.hpp"
 #include <stdexcept>
 #include <sys/stat.h>
+#include "gfx/gfx-texture-loader.hpp"
 #include "obs/gs/gs-helper.hpp"
 
 #define ST "Filter.Displacement"
@@ -72,21 +73,33 @@ void displacement_instance::update(obs_data_t* settings)
 	_scale[0] = _scale[1] = static_cast<float_t>(obs_data_get_double(settings, ST_SCALE));
 	_scale_type           = static_cast<float_t>(obs_data_get_double(settings, ST_SCALE_TYPE) / 100.0);
 
-	std::string new_file = obs_data_get_string(settings, ST_FILE);
-	if (new_file != _texture_file) {
-		try {
-			_texture      = std::make_shared<gs::texture>(new_file);
-			_texture_file = new_file;
-		} catch (...) {
-			_texture.reset();
-		}
-	}
+	// The texture itself is loaded in the background, see video_tick.
+	std::unique_lock<std::mutex> ul(_texture_lock);
+	_texture_file = obs_data_get_string(settings, ST_FILE);
 }
 
 void displacement_instance::video_tick(float_t)
 {
 	_width  = obs_source_get_base_width(_self);
 	_height = obs_source_get_base_height(_self);
+
+	std::string file;
+	{
+		std::unique_lock<std::mutex> ul(_texture_lock);
+		file = _texture_file;
+	}
+
+	if (file.empty()) {
+		_texture.reset();
+	} else {
+		// Keep the previous displacement map until the new one has been loaded.
+		bool failed = false;
+		if (auto texture = gfx::texture_loader::get()->load(file, failed); texture) {
+			_texture = texture;
+		} else if (failed) {
+			_texture.reset();
+		}
+	}
 }
 
 void displacement_instance::video_render(gs_effect_t*)
@@ -96,10 +109,8 @@ void displacement_instance::video_render(gs_effect_t*)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Displacement Mapping '%s' on '%s'", obs_source_get_name(_self),
 						  obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 	if (!obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
 		obs_source_skip_video_filter(_self);
@@ -118,6 +129,7 @@ void displacement_instance::video_render(gs_effect_t*)
 
 std::string displacement_instance::get_file()
 {
+	std::unique_lock<std::mutex> ul(_texture_lock);
 	return _texture_file;
 }
 
@@ -19,6 +19,7 @@
 
 #pragma once
 #include "common.hpp"
+#include <mutex>
 #include "obs/gs/gs-effect.hpp"
 #include "obs/obs-source-factory.hpp"
 
@@ -28,6 +29,7 @@ namespace streamfx::filter::displacement {
 
 		// Displacement Map
 		std::shared_ptr<gs::texture> _texture;
+		std::mutex                   _texture_lock; // Guards _texture_file, which is written by update().
 		std::string                  _texture_file;
 		float_t                      _scale[2];
 		float_t                      _scale_type;
@@ -23,6 +23,7 @@
 #include <stdexcept>
 #include <vector>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 
 // Filter to allow dynamic masking
 // Allow any channel to affect any other channel
@@ -51,21 +52,14 @@ static std::pair<channel, const char*> channel_translations[] = {
 };
 
 dynamic_mask_instance::dynamic_mask_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _translation_map(), _effect(), _have_filter_texture(false), _filter_rt(),
-	  _filter_texture(), _have_input_texture(false), _input(), _input_capture(), _input_texture(),
-	  _have_final_texture(false), _final_rt(), _final_texture(), _channels(), _precalc()
+	: obs::source_instance(settings, self), _translation_map(), _effects(), _effect_defines(), _effect(),
+	  _have_filter_texture(false), _filter_rt(), _filter_texture(), _have_input_texture(false), _input(),
+	  _input_capture(), _input_texture(), _have_final_texture(false), _final_rt(), _final_texture(), _channels(),
+	  _precalc()
 {
-	_filter_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_final_rt  = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-
 	{
 		char* file = obs_module_file("effects/channel-mask.effect");
-		try {
-			_effect = gs::effect::create(file);
-		} catch (const std::exception& ex) {
-			DLOG_ERROR("Loading channel mask effect failed with error(s):\n%s", ex.what());
-		}
-		assert(_effect != nullptr);
+		_effects   = std::make_shared<gs::effect_permutations>(file);
 		bfree(file);
 	}
 
@@ -140,6 +134,22 @@ void dynamic_mask_instance::update(obs_data_t* settings)
 			ch->ptr[static_cast<size_t>(kv2.first)] = found->second.values.ptr[static_cast<size_t>(kv2.first)];
 		}
 	}
+
+	// Compile out rows of the matrix that are all zero, as they do not contribute anything to the mask. The variant is
+	//  picked on the graphics thread, which is the only one allowed to touch _effect.
+	{
+		auto defines = std::make_shared<gs::effect::defines_t>();
+		std::pair<const char*, vec4*> rows[] = {{"MASK_SKIP_R", &_precalc.matrix.x},
+												{"MASK_SKIP_G", &_precalc.matrix.y},
+												{"MASK_SKIP_B", &_precalc.matrix.z},
+												{"MASK_SKIP_A", &_precalc.matrix.t}};
+		for (auto& row : rows) {
+			if ((row.second->x == 0) && (row.second->y == 0) && (row.second->z == 0) && (row.second->w == 0)) {
+				defines->emplace(row.first, "");
+			}
+		}
+		std::atomic_store(&_effect_defines, std::shared_ptr<const gs::effect::defines_t>(std::move(defines)));
+	}
 }
 
 void dynamic_mask_instance::save(obs_data_t* settings)
@@ -182,9 +192,21 @@ void dynamic_mask_instance::input_renamed(obs::deprecated_source*, std::string o
 
 void dynamic_mask_instance::video_tick(float)
 {
+	if (auto defines = std::atomic_exchange(&_effect_defines, {}); defines) {
+		try {
+			_effect = _effects->get(*defines);
+		} catch (const std::exception& ex) {
+			DLOG_ERROR("Loading channel mask effect failed with error(s):\n%s", ex.what());
+		}
+	}
+
 	_have_input_texture  = false;
 	_have_filter_texture = false;
 	_have_final_texture  = false;
+
+	// Return the masked result to the pool, it is acquired again on the next render.
+	_final_texture.reset();
+	_final_rt.reset();
 }
 
 void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
@@ -202,20 +224,18 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Dynamic Mask '%s' on '%s'", obs_source_get_name(_self),
 						  obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 	gs_effect_t* default_effect = obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
 
 	try { // Capture filter and input
 		if (!_have_filter_texture) {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
 
 			if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+				_filter_rt = gs::rendertarget_pool::get()->acquire(width, height, GS_RGBA);
+
 				auto op = _filter_rt->render(width, height);
 
 				gs_blend_state_push();
@@ -247,10 +267,8 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 		}
 
 		if (!_have_input_texture) {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_capture, "Capture '%s'",
 								 obs_source_get_name(_input_capture->get_object())};
-#endif
 
 			_input_texture      = _input_capture->render(_input->width(), _input->height());
 			_have_input_texture = true;
@@ -258,11 +276,11 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 
 		// Draw source
 		if (!_have_final_texture) {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_convert, "Masking"};
-#endif
 
 			{
+				_final_rt = gs::rendertarget_pool::get()->acquire(width, height, GS_RGBA);
+
 				auto op = _final_rt->render(width, height);
 
 				gs_blend_state_push();
@@ -298,6 +316,11 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 
 			_final_texture      = _final_rt->get_texture();
 			_have_final_texture = true;
+
+			// The captures are only intermediates for masking, return them to the pool right away.
+			_filter_texture.reset();
+			_filter_rt.reset();
+			_input_texture.reset();
 		}
 	} catch (...) {
 		obs_source_skip_video_filter(_self);
@@ -308,16 +331,14 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 		obs_source_skip_video_filter(_self);
 		return;
 	}
-	if (!_filter_texture->get_object() || !_input_texture->get_object() || !_final_texture->get_object()) {
+	if (!_final_texture || !_final_texture->get_object()) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
 
 	// Draw source
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		// It is important that we do not modify the blend state here, as it is set correctly by OBS
 		gs_set_cull_mode(GS_NEITHER);
@@ -394,7 +415,7 @@ obs_properties_t* dynamic_mask_factory::get_properties2(dynamic_mask_instance* d
 				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_video_sources);
+			obs::source_tracker::source_kind::VideoInput);
 		obs::source_tracker::get()->enumerate(
 			[&p](std::string name, obs_source_t*) {
 				std::stringstream sstr;
@@ -402,7 +423,7 @@ obs_properties_t* dynamic_mask_factory::get_properties2(dynamic_mask_instance* d
 				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_scenes);
+			obs::source_tracker::source_kind::Scene);
 	}
 
 	const char* pri_chs[] = {S_CHANNEL_RED, S_CHANNEL_GREEN, S_CHANNEL_BLUE, S_CHANNEL_ALPHA};
@@ -33,7 +33,9 @@ namespace streamfx::filter::dynamic_mask {
 	class dynamic_mask_instance : public obs::source_instance {
 		std::map<std::tuple<channel, channel, std::string>, std::string> _translation_map;
 
-		gs::effect _effect;
+		std::shared_ptr<gs::effect_permutations>     _effects;
+		std::shared_ptr<const gs::effect::defines_t> _effect_defines; // Handed from update() to video_tick().
+		gs::effect                                   _effect;
 
 		bool                              _have_filter_texture;
 		std::shared_ptr<gs::rendertarget> _filter_rt;
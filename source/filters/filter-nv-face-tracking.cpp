@@ -56,9 +56,11 @@ face_tracking_instance::face_tracking_instance(obs_data_t* settings, obs_source_
 	  _cuda(face_tracking_factory::get()->get_cuda()), _cuda_ctx(face_tracking_factory::get()->get_cuda_context()),
 	  _cuda_stream(),
 
-	  _ar_library(face_tracking_factory::get()->get_ar()), _ar_loaded(false), _ar_feature(), _ar_is_tracking(false),
-	  _ar_bboxes_confidence(), _ar_bboxes_data(), _ar_bboxes(), _ar_texture(), _ar_texture_cuda_fresh(false),
-	  _ar_texture_cuda(), _ar_texture_cuda_mem(), _ar_image(), _ar_image_bgr(), _ar_image_temp()
+	  _ar_library(face_tracking_factory::get()->get_ar()), _ar_loaded(false), _ar_feature(), _ar_bboxes_confidence(),
+	  _ar_bboxes_data(), _ar_bboxes(), _ar_texture(), _ar_texture_cuda_fresh(false), _ar_texture_cuda(),
+	  _ar_texture_cuda_mem(), _ar_image(), _ar_image_bgr(), _ar_image_temp(),
+
+	  _async_group(std::make_shared<util::threadpool_group>())
 {
 #ifdef ENABLE_PROFILING
 	// Profiling
@@ -93,9 +95,8 @@ face_tracking_instance::face_tracking_instance(obs_data_t* settings, obs_source_
 
 face_tracking_instance::~face_tracking_instance()
 {
-	// Kill pending tasks.
-	streamfx::threadpool()->pop(_async_initialize);
-	streamfx::threadpool()->pop(_async_track);
+	// Kill pending tasks, anything already running bails out once it fails to acquire the source.
+	_async_group->cancel();
 
 	_ar_loaded.store(false);
 	std::unique_lock<std::mutex> alk{_ar_lock};
@@ -124,8 +125,10 @@ void face_tracking_instance::async_initialize(std::shared_ptr<void> ptr)
 			data->models_path = models_path.string();
 		}
 
-		_async_initialize = streamfx::threadpool()->push(
-			std::bind(&face_tracking_instance::async_initialize, this, std::placeholders::_1), data);
+		util::threadpool_options options;
+		options.group = _async_group;
+		streamfx::threadpool()->push(std::bind(&face_tracking_instance::async_initialize, this, std::placeholders::_1),
+									 data, options);
 	} else {
 		std::shared_ptr<async_data> data = std::static_pointer_cast<async_data>(ptr);
 
@@ -195,8 +198,6 @@ void face_tracking_instance::async_initialize(std::shared_ptr<void> ptr)
 		} else {
 			_ar_loaded = true;
 		}
-
-		_async_initialize.reset();
 	}
 }
 
@@ -210,16 +211,11 @@ void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
 		return;
 
 	if (!ptr) {
-		// Check if we can track.
-		if (_ar_is_tracking)
-			return; // Can't track a new frame right now.
+		// Don't push additional tracking frames while processing one.
+		if (_async_group->pending() > 0)
+			return;
 
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_convert, "Start Asynchronous Tracking"};
-#endif
-
-		// Don't push additional tracking frames while processing one.
-		_ar_is_tracking = true;
 
 		// Spawn the work for the threadpool.
 		std::shared_ptr<async_data> data = std::make_shared<async_data>();
@@ -245,9 +241,13 @@ void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
 			gs_copy_texture(_ar_texture->get_object(), _rt->get_texture()->get_object());
 		}
 
-		// Push work
-		_async_track = streamfx::threadpool()->push(
-			std::bind(&face_tracking_instance::async_track, this, std::placeholders::_1), data);
+		// Push work, which is only useful if it can start within the next two frames.
+		util::threadpool_options options;
+		options.priority = util::threadpool_priority::Realtime;
+		options.deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(obs_get_frame_interval_ns() * 2);
+		options.group    = _async_group;
+		streamfx::threadpool()->push(std::bind(&face_tracking_instance::async_track, this, std::placeholders::_1), data,
+									 options);
 	} else {
 		// Prevent conflicts.
 		std::unique_lock<std::mutex> alk{_ar_lock};
@@ -423,10 +423,6 @@ void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
 			}
 		}
 
-		_async_track.reset();
-
-		// Allow new frames to be queued again.
-		_ar_is_tracking = false;
 	}
 }
 
@@ -526,10 +522,8 @@ void face_tracking_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "NVIDIA Face Tracking '%s'...", obs_source_get_name(_self)};
 	gs::debug_marker gdmp2{gs::debug_color_source, "... on '%s'", obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 	if (!_rt_is_fresh) { // Capture the filter stack "below" us.
 #ifdef ENABLE_PROFILING
@@ -537,9 +531,7 @@ void face_tracking_instance::video_render(gs_effect_t* effect)
 #endif
 
 		{
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
 
 			if (obs_source_process_filter_begin(_self, _rt->get_color_format(), OBS_ALLOW_DIRECT_RENDERING)) {
 				auto op  = _rt->render(_size.first, _size.second);
@@ -564,9 +556,7 @@ void face_tracking_instance::video_render(gs_effect_t* effect)
 	}
 
 	{ // Draw Texture
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		gs_effect_set_texture(gs_effect_get_param_by_name(effect ? effect : default_effect, "image"),
 							  _rt->get_texture()->get_object());
@@ -70,7 +70,6 @@ namespace streamfx::filter::nvidia {
 		std::shared_ptr<::nvidia::ar::ar>          _ar_library;
 		std::atomic_bool                           _ar_loaded;
 		std::shared_ptr<nvAR_Feature>              _ar_feature;
-		std::atomic_bool                           _ar_is_tracking;
 		std::mutex                                 _ar_lock;
 		std::vector<float_t>                       _ar_bboxes_confidence;
 		std::vector<NvAR_Rect>                     _ar_bboxes_data;
@@ -84,8 +83,7 @@ namespace streamfx::filter::nvidia {
 		NvCVImage                                  _ar_image_temp;
 
 		// Tasks
-		std::shared_ptr<::util::threadpool::task> _async_initialize;
-		std::shared_ptr<::util::threadpool::task> _async_track;
+		std::shared_ptr<::util::threadpool_group> _async_group;
 
 #ifdef ENABLE_PROFILING
 		// Profiling
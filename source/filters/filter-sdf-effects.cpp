@@ -21,6 +21,7 @@
 #include "strings.hpp"
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 
 #define LOG_PREFIX "<filter-sdf-effects> "
 
@@ -78,19 +79,7 @@ sdf_effects_instance::sdf_effects_instance(obs_data_t* settings, obs_source_t* s
 	  _outline_offset(), _outline_sharpness(), _outline_sharpness_inv()
 {
 	{
-		auto gctx        = gs::context();
-		vec4 transparent = {0, 0, 0, 0};
-
-		_source_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		_sdf_write = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
-		_sdf_read  = std::make_shared<gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
-		_output_rt = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-
-		std::shared_ptr<gs::rendertarget> initialize_rts[] = {_source_rt, _sdf_write, _sdf_read, _output_rt};
-		for (auto rt : initialize_rts) {
-			auto op = rt->render(1, 1);
-			gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &transparent, 0, 0);
-		}
+		auto gctx = gs::context();
 
 		std::pair<const char*, gs::effect&> load_arr[] = {
 			{"effects/sdf/sdf-producer.effect", _sdf_producer_effect},
@@ -264,6 +253,14 @@ void sdf_effects_instance::video_tick(float_t)
 	if (obs_source_t* target = obs_filter_get_target(_self); target != nullptr) {
 		_source_rendered = false;
 		_output_rendered = false;
+
+		// Return all render targets to the pool, they are acquired again on the next render.
+		_source_texture.reset();
+		_source_rt.reset();
+		_sdf_texture.reset();
+		_sdf_rt.reset();
+		_output_texture.reset();
+		_output_rt.reset();
 	}
 }
 
@@ -281,10 +278,8 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "SDF Effects '%s' on '%s'", obs_source_get_name(_self),
 						  obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 	auto gctx              = gs::context();
 	vec4 color_transparent = {0, 0, 0, 0};
@@ -307,9 +302,9 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 		if (!_source_rendered) {
 			// Store input texture.
 			{
-#ifdef ENABLE_PROFILING
 				gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
+
+				_source_rt = gs::rendertarget_pool::get()->acquire(baseW, baseH, GS_RGBA);
 
 				auto op = _source_rt->render(baseW, baseH);
 				gs_ortho(0, static_cast<float>(baseW), 0, static_cast<float>(baseH), -1, 1);
@@ -328,11 +323,6 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 
 			// Generate SDF Buffers
 			{
-				_sdf_read->get_texture(_sdf_texture);
-				if (!_sdf_texture) {
-					throw std::runtime_error("SDF Backbuffer empty");
-				}
-
 				if (!_sdf_producer_effect) {
 					throw std::runtime_error("SDF Effect no loaded");
 				}
@@ -347,27 +337,53 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 				if (sdfH <= 1) {
 					sdfH = 1.0;
 				}
+				uint32_t sdf_width  = uint32_t(sdfW);
+				uint32_t sdf_height = uint32_t(sdfH);
+
+				// Jump Flooding: Seed once, then flood with halving step sizes, followed by one extra step of 1 to
+				// fix the few errors plain JFA leaves behind. Each pass reads from sdf_read and writes to sdf_write,
+				// both of which are transient. Only the final result is kept until the next tick.
+				auto pool      = gs::rendertarget_pool::get();
+				auto sdf_read  = pool->acquire(sdf_width, sdf_height, GS_RGBA32F);
+				auto sdf_write = pool->acquire(sdf_width, sdf_height, GS_RGBA32F);
+				auto jfa_pass  = [&](const char* technique, float_t step) {
+					{
+						auto op = sdf_write->render(sdf_width, sdf_height);
+						gs_ortho(0, 1, 0, 1, -1, 1);
+						gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+
+						_sdf_producer_effect.get_parameter("_image").set_texture(_source_texture);
+						_sdf_producer_effect.get_parameter("_size").set_float2(float_t(sdf_width), float_t(sdf_height));
+						_sdf_producer_effect.get_parameter("_sdf").set_texture(sdf_read->get_object());
+						_sdf_producer_effect.get_parameter("_step").set_float(step);
+						_sdf_producer_effect.get_parameter("_threshold").set_float(_sdf_threshold);
+
+						while (gs_effect_loop(_sdf_producer_effect.get_object(), technique)) {
+							streamfx::gs_draw_fullscreen_tri();
+						}
+					}
+					std::swap(sdf_read, sdf_write);
+				};
 
 				{
-#ifdef ENABLE_PROFILING
 					gs::debug_marker gdm{gs::debug_color_convert, "Update Distance Field"};
-#endif
 
-					auto op = _sdf_write->render(uint32_t(sdfW), uint32_t(sdfH));
-					gs_ortho(0, 1, 0, 1, -1, 1);
-					gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+					jfa_pass("Seed", 0);
 
-					_sdf_producer_effect.get_parameter("_image").set_texture(_source_texture);
-					_sdf_producer_effect.get_parameter("_size").set_float2(float_t(sdfW), float_t(sdfH));
-					_sdf_producer_effect.get_parameter("_sdf").set_texture(_sdf_texture);
-					_sdf_producer_effect.get_parameter("_threshold").set_float(_sdf_threshold);
-
-					while (gs_effect_loop(_sdf_producer_effect.get_object(), "Draw")) {
-						streamfx::gs_draw_fullscreen_tri();
+					uint32_t step = 1;
+					while ((step << 1) < std::max(sdf_width, sdf_height)) {
+						step <<= 1;
+					}
+					for (; step > 0; step >>= 1) {
+						jfa_pass("Jump", float_t(step));
 					}
+					jfa_pass("Jump", 1);
+
+					jfa_pass("Resolve", 0);
 				}
-				std::swap(_sdf_read, _sdf_write);
-				_sdf_read->get_texture(_sdf_texture);
+
+				_sdf_rt = sdf_read;
+				_sdf_rt->get_texture(_sdf_texture);
 				if (!_sdf_texture) {
 					throw std::runtime_error("SDF Backbuffer empty");
 				}
@@ -407,9 +423,9 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 
 		// Optimized Render path.
 		try {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_convert, "Calculate"};
-#endif
+
+			_output_rt = gs::rendertarget_pool::get()->acquire(baseW, baseH, GS_RGBA);
 
 			auto op = _output_rt->render(baseW, baseH);
 			gs_ortho(0, 1, 0, 1, 0, 1);
@@ -492,10 +508,21 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 		} catch (...) {
 		}
 
-		_output_rt->get_texture(_output_texture);
+		if (_output_rt) {
+			_output_rt->get_texture(_output_texture);
+		}
 
 		gs_blend_state_pop();
 		_output_rendered = true;
+
+		// The distance field and the capture are only intermediates, return them to the pool right away. The
+		//  capture is kept if no effect is enabled, as it is then drawn directly.
+		_sdf_texture.reset();
+		_sdf_rt.reset();
+		if (_output_texture != _source_texture) {
+			_source_texture.reset();
+			_source_rt.reset();
+		}
 	}
 
 	if (!_output_texture) {
@@ -504,9 +531,7 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 	}
 
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		gs_eparam_t* ep = gs_effect_get_param_by_name(final_effect, "image");
 		if (ep) {
@@ -37,8 +37,7 @@ namespace streamfx::filter::sdf_effects {
 		bool                              _source_rendered;
 
 		// Distance Field
-		std::shared_ptr<gs::rendertarget> _sdf_write;
-		std::shared_ptr<gs::rendertarget> _sdf_read;
+		std::shared_ptr<gs::rendertarget> _sdf_rt;
 		std::shared_ptr<gs::texture>      _sdf_texture;
 		double_t                          _sdf_scale;
 		float_t                           _sdf_threshold;
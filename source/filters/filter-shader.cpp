@@ -83,15 +83,11 @@ void shader_instance::video_render(gs_effect_t* effect)
 			throw std::runtime_error("No effect, or invalid base size.");
 		}
 
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdmp{gs::debug_color_source, "Shader Filter '%s' on '%s'", obs_source_get_name(_self),
 							  obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 		{
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_source, "Cache"};
-#endif
 
 			auto op = _rt->render(_fx->base_width(), _fx->base_height());
 
@@ -118,9 +114,7 @@ void shader_instance::video_render(gs_effect_t* effect)
 		}
 
 		{
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 			_fx->prepare_render();
 			_fx->set_input_a(_rt->get_texture());
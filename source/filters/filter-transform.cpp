@@ -80,8 +80,8 @@ enum RotationOrder : int64_t {
 };
 
 transform_instance::transform_instance(obs_data_t* data, obs_source_t* context)
-	: obs::source_instance(data, context), _cache_rendered(), _mipmap_enabled(), _source_rendered(), _source_size(),
-	  _update_mesh(), _rotation_order(), _camera_orthographic(), _camera_fov()
+	: obs::source_instance(data, context), _cache_rendered(), _mipmap_enabled(), _mipmap_rendered(), _mipmap_failed(),
+	  _source_rendered(), _source_size(), _update_mesh(), _rotation_order(), _camera_orthographic(), _camera_fov()
 {
 	_cache_rt      = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 	_source_rt     = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
@@ -148,6 +148,7 @@ void transform_instance::update(obs_data_t* settings)
 
 	// Mipmapping
 	_mipmap_enabled = obs_data_get_bool(settings, ST_MIPMAPPING);
+	_mipmap_failed  = false;
 
 	_update_mesh = true;
 }
@@ -285,10 +286,8 @@ void transform_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "3D Transform '%s' on '%s'", obs_source_get_name(_self),
 						  obs_source_get_name(obs_filter_get_parent(_self))};
-#endif
 
 	uint32_t cache_width  = base_width;
 	uint32_t cache_height = base_height;
@@ -312,9 +311,7 @@ void transform_instance::video_render(gs_effect_t* effect)
 	}
 
 	if (!_cache_rendered) {
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_cache, "Cache"};
-#endif
 
 		auto op = _cache_rt->render(cache_width, cache_height);
 
@@ -352,35 +349,33 @@ void transform_instance::video_render(gs_effect_t* effect)
 	}
 
 	if (_mipmap_enabled) {
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_convert, "Mipmap"};
-#endif
 
 		if (!_mipmap_texture || (_mipmap_texture->get_width() != cache_width)
 			|| (_mipmap_texture->get_height() != cache_height)) {
-#ifdef ENABLE_PROFILING
 			gs::debug_marker gdr{gs::debug_color_allocate, "Allocate Mipmapped Texture"};
-#endif
 
 			std::size_t mip_levels = std::max(util::math::get_power_of_two_exponent_ceil(cache_width),
 											  util::math::get_power_of_two_exponent_ceil(cache_height));
 			_mipmap_texture =
 				std::make_shared<gs::texture>(cache_width, cache_height, GS_RGBA, static_cast<uint32_t>(mip_levels),
 											  nullptr, gs::texture::flags::None);
+			_mipmap_failed = false;
 		}
-		_mipmapper.rebuild(_cache_texture, _mipmap_texture);
-
-		_mipmap_rendered = true;
-		if (!_mipmap_texture) {
-			obs_source_skip_video_filter(_self);
-			return;
+		if (!_mipmap_rendered && !_mipmap_failed) {
+			try {
+				_mipmapper.rebuild(_cache_texture, _mipmap_texture);
+				_mipmap_rendered = true;
+			} catch (const std::exception& ex) {
+				// Draw the full size texture instead, until the size or settings change.
+				DLOG_WARNING("<filter-transform> Failed to generate mipmaps: %s", ex.what());
+				_mipmap_failed = true;
+			}
 		}
 	}
 
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_convert, "Transform"};
-#endif
 
 		auto op = _source_rt->render(base_width, base_height);
 
@@ -409,9 +404,8 @@ void transform_instance::video_render(gs_effect_t* effect)
 		gs_load_vertexbuffer(_vertex_buffer->update(false));
 		gs_load_indexbuffer(nullptr);
 		gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"),
-							  _mipmap_enabled
-								  ? (_mipmap_texture ? _mipmap_texture->get_object() : _cache_texture->get_object())
-								  : _cache_texture->get_object());
+							  (_mipmap_enabled && _mipmap_rendered) ? _mipmap_texture->get_object()
+																	: _cache_texture->get_object());
 		while (gs_effect_loop(default_effect, "Draw")) {
 			gs_draw(GS_TRISTRIP, 0, 4);
 		}
@@ -426,9 +420,7 @@ void transform_instance::video_render(gs_effect_t* effect)
 	}
 
 	{
-#ifdef ENABLE_PROFILING
 		gs::debug_marker gdm{gs::debug_color_render, "Render"};
-#endif
 
 		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), _source_texture->get_object());
 		while (gs_effect_loop(effect, "Draw")) {
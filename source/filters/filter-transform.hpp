@@ -36,6 +36,7 @@ namespace streamfx::filter::transform {
 		// Mip-mapping
 		bool                         _mipmap_enabled;
 		bool                         _mipmap_rendered;
+		bool                         _mipmap_failed; // Don't retry until the size or settings change.
 		gs::mipmapper                _mipmapper;
 		std::shared_ptr<gs::texture> _mipmap_texture;
 
@@ -26,13 +26,13 @@
 namespace gfx {
 	namespace blur {
 		class box_linear_data {
-			gs::effect _effect;
+			std::shared_ptr<gs::effect_permutations> _effects;
 
 			public:
 			box_linear_data();
 			virtual ~box_linear_data();
 
-			gs::effect get_effect();
+			gs::effect get_effect(double_t size);
 		};
 
 		class box_linear_factory : public ::gfx::blur::ifactory {
@@ -88,9 +88,6 @@ namespace gfx {
 			std::shared_ptr<::gs::texture>      _input_texture;
 			std::shared_ptr<::gs::rendertarget> _rendertarget;
 
-			private:
-			std::shared_ptr<::gs::rendertarget> _rendertarget2;
-
 			public:
 			box_linear();
 			virtual ~box_linear() override;
@@ -20,6 +20,7 @@
 #include <memory>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "plugin.hpp"
 
 #ifdef _MSC_VER
@@ -39,7 +40,7 @@ gfx::blur::box_data::box_data()
 	auto gctx = gs::context();
 	try {
 		char* file = obs_module_file("effects/blur/box.effect");
-		_effect    = gs::effect::create(file);
+		_effects   = std::make_shared<gs::effect_permutations>(file);
 		bfree(file);
 	} catch (...) {
 		DLOG_ERROR("<gfx::blur::box> Failed to load _effect.");
@@ -49,12 +50,25 @@ gfx::blur::box_data::box_data()
 gfx::blur::box_data::~box_data()
 {
 	auto gctx = gs::context();
-	_effect.reset();
+	_effects.reset();
 }
 
-gs::effect gfx::blur::box_data::get_effect()
+gs::effect gfx::blur::box_data::get_effect(double_t size)
 {
-	return _effect;
+	if (!_effects)
+		return {};
+
+	// Compile against the smallest power of two loop bound that covers the size, so short loops can be unrolled.
+	std::size_t bound = 8;
+	while ((bound < MAX_BLUR_SIZE) && (double_t(bound) < size))
+		bound *= 2;
+
+	try {
+		return _effects->get({{"MAX_BLUR_SIZE", std::to_string(bound)}});
+	} catch (...) {
+		DLOG_ERROR("<gfx::blur::box> Failed to compile variant for size %zu.", bound);
+		return {};
+	}
 }
 
 gfx::blur::box_factory::box_factory() {}
@@ -196,9 +210,8 @@ std::shared_ptr<::gfx::blur::box_data> gfx::blur::box_factory::data()
 
 gfx::blur::box::box() : _data(::gfx::blur::box_factory::get().data()), _size(1.), _step_scale({1., 1.})
 {
-	auto gctx      = gs::context();
-	_rendertarget  = std::make_shared<::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_rendertarget2 = std::make_shared<::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	auto gctx     = gs::context();
+	_rendertarget = std::make_shared<::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 }
 
 gfx::blur::box::~box() {}
@@ -254,9 +267,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Box Blur");
-#endif
 
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
@@ -275,8 +286,11 @@ std::shared_ptr<::gs::texture> gfx::blur::box::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// Two Pass Blur
-	gs::effect effect = _data->get_effect();
+	gs::effect effect = _data->get_effect(_size);
 	if (effect) {
+		// The horizontal pass is only an intermediate, so it can share memory with other blurs.
+		auto rendertarget2 = ::gs::rendertarget_pool::get()->acquire(uint32_t(width), uint32_t(height), GS_RGBA);
+
 		// Pass 1
 		effect.get_parameter("pImage").set_texture(_input_texture);
 		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), 0.f);
@@ -285,11 +299,9 @@ std::shared_ptr<::gs::texture> gfx::blur::box::render()
 		effect.get_parameter("pSizeInverseMul").set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
 
 		{
-#ifdef ENABLE_PROFILING
 			auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Horizontal");
-#endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			auto op = rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
@@ -297,13 +309,11 @@ std::shared_ptr<::gs::texture> gfx::blur::box::render()
 		}
 
 		// Pass 2
-		effect.get_parameter("pImage").set_texture(_rendertarget2->get_texture());
+		effect.get_parameter("pImage").set_texture(rendertarget2->get_texture());
 		effect.get_parameter("pImageTexel").set_float2(0.f, float_t(1.f / height));
 
 		{
-#ifdef ENABLE_PROFILING
 			auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Vertical");
-#endif
 
 			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
@@ -344,9 +354,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_directional::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Box Directional Blur");
-#endif
 
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
@@ -365,7 +373,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_directional::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// One Pass Blur
-	gs::effect effect = _data->get_effect();
+	gs::effect effect = _data->get_effect(_size);
 	if (effect) {
 		effect.get_parameter("pImage").set_texture(_input_texture);
 		effect.get_parameter("pImageTexel")
@@ -419,9 +427,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_rotational::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Box Rotational Blur");
-#endif
 
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
@@ -440,7 +446,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_rotational::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// One Pass Blur
-	gs::effect effect = _data->get_effect();
+	gs::effect effect = _data->get_effect(_size);
 	if (effect) {
 		effect.get_parameter("pImage").set_texture(_input_texture);
 		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
@@ -485,9 +491,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_zoom::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Box Zoom Blur");
-#endif
 
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
@@ -506,7 +510,7 @@ std::shared_ptr<::gs::texture> gfx::blur::box_zoom::render()
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// One Pass Blur
-	gs::effect effect = _data->get_effect();
+	gs::effect effect = _data->get_effect(_size);
 	if (effect) {
 		effect.get_parameter("pImage").set_texture(_input_texture);
 		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
@@ -229,9 +229,7 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Dual-Filtering Blur");
-#endif
 
 	auto effect = _data->get_effect();
 	if (!effect) {
@@ -258,9 +256,7 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 
 	// Downsample
 	for (std::size_t n = 1; n <= actual_iterations; n++) {
-#ifdef ENABLE_PROFILING
-		auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Down %" PRIuMAX, n);
-#endif
+		auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Down %" PRIuMAX, uintmax_t(n));
 
 		// Select Texture
 		std::shared_ptr<gs::texture> tex_cur;
@@ -295,9 +291,7 @@ std::shared_ptr<::gs::texture> gfx::blur::dual_filtering::render()
 
 	// Upsample
 	for (std::size_t n = actual_iterations; n > 0; n--) {
-#ifdef ENABLE_PROFILING
-		auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Up %" PRIuMAX, n);
-#endif
+		auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Up %" PRIuMAX, uintmax_t(n));
 
 		// Select Texture
 		std::shared_ptr<gs::texture> tex_in = _rts[n]->get_texture();
@@ -292,9 +292,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_linear::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Gaussian Linear Blur");
-#endif
 
 	gs::effect effect = _data->get_effect();
 	auto       kernel = _data->get_kernel(size_t(_size));
@@ -330,9 +328,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_linear::render()
 		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), 0.f);
 
 		{
-#ifdef ENABLE_PROFILING
 			auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Horizontal");
-#endif
 
 			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
@@ -350,9 +346,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_linear::render()
 		effect.get_parameter("pImageTexel").set_float2(0.f, float_t(1.f / height));
 
 		{
-#ifdef ENABLE_PROFILING
 			auto gdm = gs::debug_marker(gs::debug_color_azure_radiance, "Vertical");
-#endif
 
 			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
@@ -397,9 +391,7 @@ std::shared_ptr<::gs::texture> gfx::blur::gaussian_linear_directional::render()
 {
 	auto gctx = gs::context();
 
-#ifdef ENABLE_PROFILING
 	auto gdmp = gs::debug_marker(gs::debug_color_azure_radiance, "Gaussian Linear Directional Blur");
-#endif
 
 	gs::effect effect = _data->get_effect();
 	auto       kernel = _data->get_kernel(size_t(_size));
@@ -18,6 +18,7 @@
 #include "gfx-source-texture.hpp"
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 
 gfx::source_texture::~source_texture()
 {
@@ -35,7 +36,6 @@ gfx::source_texture::source_texture(obs_source_t* parent)
 		throw std::invalid_argument("_parent must not be null");
 	}
 	_parent = std::make_shared<obs::deprecated_source>(parent, false, false);
-	_rt     = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 }
 
 gfx::source_texture::source_texture(obs_source_t* _source, obs_source_t* _parent) : source_texture(_parent)
@@ -77,7 +77,6 @@ gfx::source_texture::source_texture(std::shared_ptr<obs::deprecated_source> pchi
 	}
 	this->_child  = pchild;
 	this->_parent = pparent;
-	this->_rt     = std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 }
 
 gfx::source_texture::source_texture(std::shared_ptr<obs::deprecated_source> _child, obs_source_t* _parent)
@@ -114,24 +113,82 @@ std::shared_ptr<gs::texture> gfx::source_texture::render(std::size_t width, std:
 	if ((height == 0) || (height >= 16384)) {
 		throw std::runtime_error("Height too large or too small.");
 	}
-	if (_child->destroyed() || _parent->destroyed()) {
+	if (!_child || _child->destroyed() || _parent->destroyed()) {
 		return nullptr;
 	}
 
-	if (_child) {
-#ifdef ENABLE_PROFILING
-		auto cctr =
-			gs::debug_marker(gs::debug_color_capture, "gfx::source_texture '%s'", obs_source_get_name(_child->get()));
-#endif
-		auto op = _rt->render(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+	return source_texture_factory::get()->render(_child->get(), static_cast<uint32_t>(width),
+												 static_cast<uint32_t>(height));
+}
+
+std::shared_ptr<gfx::source_texture_factory> gfx::source_texture_factory::factory_instance;
+
+void gfx::source_texture_factory::tick_handler(void* ptr, float_t) noexcept
+try {
+	auto* self = reinterpret_cast<gfx::source_texture_factory*>(ptr);
+
+	// Release the captures outside of the lock, as this returns their render targets to the pool.
+	std::map<std::tuple<obs_source_t*, uint32_t, uint32_t>, std::shared_ptr<gs::texture>> expired;
+	{
+		std::unique_lock<std::mutex> ul(self->_lock);
+		expired.swap(self->_cache);
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+gfx::source_texture_factory::source_texture_factory() : _lock(), _cache()
+{
+	obs_add_tick_callback(&tick_handler, this);
+}
+
+gfx::source_texture_factory::~source_texture_factory()
+{
+	obs_remove_tick_callback(&tick_handler, this);
+
+	std::unique_lock<std::mutex> ul(_lock);
+	_cache.clear();
+}
+
+std::shared_ptr<gs::texture> gfx::source_texture_factory::render(obs_source_t* source, uint32_t width,
+																 uint32_t height)
+{
+	auto key = std::make_tuple(source, width, height);
+
+	{ // Reuse a capture from this frame if there is one.
+		std::unique_lock<std::mutex> ul(_lock);
+		if (auto found = _cache.find(key); found != _cache.end()) {
+			return found->second;
+		}
+	}
+
+	// Render without holding the lock, as the source may itself contain captured sources.
+	auto     rt            = gs::rendertarget_pool::get()->acquire(width, height, GS_RGBA);
+	uint32_t source_width  = obs_source_get_width(source);
+	uint32_t source_height = obs_source_get_height(source);
+	if ((source_width == 0) || (source_height == 0)) {
+		source_width  = width;
+		source_height = height;
+	}
+	{
+		auto cctr = gs::debug_marker(gs::debug_color_capture, "gfx::source_texture '%s'", obs_source_get_name(source));
+		auto op = rt->render(width, height);
 		vec4 black;
 		vec4_zero(&black);
-		gs_ortho(0, static_cast<float>(width), 0, static_cast<float_t>(height), 0, 1);
+		// The source draws itself at its own size, so this scales it to fit the requested size.
+		gs_ortho(0, static_cast<float>(source_width), 0, static_cast<float_t>(source_height), 0, 1);
 		gs_clear(GS_CLEAR_COLOR, &black, 0, 0);
-		obs_source_video_render(_child->get());
+		obs_source_video_render(source);
 	}
 
-	std::shared_ptr<gs::texture> tex;
-	_rt->get_texture(tex);
+	// The texture keeps the render target alive for as long as anyone still uses it.
+	auto tex = std::shared_ptr<gs::texture>(new gs::texture(rt->get_object(), false), [rt](gs::texture* ptr) {
+		delete ptr;
+	});
+
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+		_cache.emplace(key, tex);
+	}
 	return tex;
 }
@@ -18,6 +18,8 @@
 #pragma once
 #include "common.hpp"
 #include <map>
+#include <mutex>
+#include <tuple>
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 #include "obs/obs-source.hpp"
@@ -27,8 +29,6 @@ namespace gfx {
 		std::shared_ptr<obs::deprecated_source> _parent;
 		std::shared_ptr<obs::deprecated_source> _child;
 
-		std::shared_ptr<gs::rendertarget> _rt;
-
 		source_texture(obs_source_t* parent);
 
 		public:
@@ -58,19 +58,25 @@ namespace gfx {
 		obs_source_t* get_parent();
 	};
 
+	/* Captures are shared by all gfx::source_texture instances and memoized per source, size and frame. This way a
+	 *  camera or scene used by several filters is only rendered once per frame, no matter how many use it. The cache
+	 *  is emptied on every tick, so that no pooled render target outlives the frame it was rendered in.
+	 */
 	class source_texture_factory {
 		friend class source_texture;
 
-		std::map<std::shared_ptr<obs_weak_source_t>, std::weak_ptr<source_texture>> _cache;
+		std::mutex _lock;
+		std::map<std::tuple<obs_source_t*, uint32_t, uint32_t>, std::shared_ptr<gs::texture>> _cache;
+
+		static void tick_handler(void* ptr, float_t time) noexcept;
 
 		public:
 		source_texture_factory();
 		~source_texture_factory();
 
-		std::shared_ptr<source_texture> get_source_texture(std::shared_ptr<obs_source_t> source);
-
-		protected:
-		void free_source_texture(std::shared_ptr<obs_source_t> source);
+		public:
+		// Render a source at the given size, or reuse a capture of it from earlier in this frame.
+		std::shared_ptr<gs::texture> render(obs_source_t* source, uint32_t width, uint32_t height);
 
 		private: // Singleton
 		static std::shared_ptr<source_texture_factory> factory_instance;
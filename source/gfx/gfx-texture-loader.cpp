@@ -0,0 +1,202 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2020 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+
+#include "gfx-texture-loader.hpp"
+#include <list>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+// Frames an unused texture is kept around, so that briefly switching away from a file does not load it again.
+#define ST_EXPIRY 300
+
+namespace {
+	struct decode_data {
+		std::weak_ptr<gfx::texture_loader> loader;
+		std::string                        file;
+		std::shared_ptr<void>              entry;
+		uint64_t                           generation;
+	};
+} // namespace
+
+static std::shared_ptr<gfx::texture_loader> texture_loader_instance;
+
+void gfx::texture_loader::tick_handler(void* ptr, float_t) noexcept
+try {
+	gfx::texture_loader* self = reinterpret_cast<gfx::texture_loader*>(ptr);
+
+	std::list<std::shared_ptr<entry>> uploads;
+	std::list<std::shared_ptr<entry>> expired;
+	{
+		std::unique_lock<std::mutex> ul(self->_lock);
+		self->_frame++;
+		for (auto iter = self->_cache.begin(); iter != self->_cache.end();) {
+			auto& kv = *iter;
+			if (kv.second->image) {
+				uploads.push_back(kv.second);
+			} else if (kv.second->texture && (kv.second->texture.use_count() > 1)) {
+				kv.second->last_used = self->_frame;
+			} else if (!kv.second->loading && ((self->_frame - kv.second->last_used) > ST_EXPIRY)) {
+				expired.push_back(kv.second);
+				iter = self->_cache.erase(iter);
+				continue;
+			}
+			iter++;
+		}
+	}
+
+	// Upload (and destroy) outside of the lock, as both need the graphics context.
+	for (auto& item : uploads) {
+		std::shared_ptr<gs_image_file_t> image;
+		uint64_t                         generation;
+		{
+			std::unique_lock<std::mutex> ul(self->_lock);
+			image.swap(item->image);
+			generation = item->image_generation;
+		}
+
+		std::shared_ptr<gs::texture> texture;
+		{
+			auto gctx = gs::context();
+			gs_image_file_init_texture(image.get());
+			if (image->texture) {
+				// Take ownership of the texture, so that freeing the image does not destroy it.
+				texture        = std::make_shared<gs::texture>(image->texture, true);
+				image->texture = nullptr;
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> ul(self->_lock);
+			item->texture   = texture;
+			item->failed    = !texture;
+			item->loading   = (item->generation != generation);
+			item->last_used = self->_frame;
+		}
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void gfx::texture_loader::decode_handler(std::shared_ptr<void> ptr) noexcept
+try {
+	auto data = std::static_pointer_cast<decode_data>(ptr);
+	auto item = std::static_pointer_cast<entry>(data->entry);
+
+	auto image = std::shared_ptr<gs_image_file_t>(new gs_image_file_t(), [](gs_image_file_t* v) {
+		{
+			auto gctx = gs::context();
+			gs_image_file_free(v);
+		}
+		delete v;
+	});
+	gs_image_file_init(image.get(), data->file.c_str());
+
+	auto self = data->loader.lock();
+	if (!self) { // Loader is gone, nothing left to do.
+		return;
+	}
+
+	std::unique_lock<std::mutex> ul(self->_lock);
+	if (item->generation != data->generation) {
+		// The file changed again while it was decoded, and the newer attempt will take care of it.
+	} else if (image->loaded) {
+		item->image            = image;
+		item->image_generation = data->generation;
+	} else {
+		DLOG_ERROR("<gfx::texture_loader> Failed to decode image file '%s'.", data->file.c_str());
+		item->texture.reset();
+		item->failed  = true;
+		item->loading = false;
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void gfx::texture_loader::initialize()
+{
+	texture_loader_instance = std::make_shared<gfx::texture_loader>();
+}
+
+void gfx::texture_loader::finalize()
+{
+	texture_loader_instance.reset();
+}
+
+std::shared_ptr<gfx::texture_loader> gfx::texture_loader::get()
+{
+	return texture_loader_instance;
+}
+
+gfx::texture_loader::texture_loader() : _lock(), _cache(), _frame(0)
+{
+	obs_add_tick_callback(&tick_handler, this);
+}
+
+gfx::texture_loader::~texture_loader()
+{
+	obs_remove_tick_callback(&tick_handler, this);
+
+	std::unique_lock<std::mutex> ul(_lock);
+	_cache.clear();
+}
+
+std::shared_ptr<gs::texture> gfx::texture_loader::load(const std::string& file, bool& failed)
+{
+	if (file.empty()) {
+		failed = true;
+		return nullptr;
+	}
+
+	auto data    = std::make_shared<decode_data>();
+	auto texture = std::shared_ptr<gs::texture>();
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+		auto                         item = std::shared_ptr<entry>();
+		if (auto found = _cache.find(file); found != _cache.end()) {
+			item            = found->second;
+			item->last_used = _frame;
+			if (!item->watch || !item->watch->changed()) {
+				failed = item->failed;
+				return item->texture;
+			}
+		} else {
+			item                   = std::make_shared<entry>();
+			item->image_generation = 0;
+			item->generation       = 0;
+			item->last_used        = _frame;
+			if (auto watcher = util::file_watcher::get(); watcher) {
+				item->watch = watcher->watch(file);
+			}
+			_cache.emplace(file, item);
+		}
+
+		// New or changed file, so (re-)load it in the background.
+		item->loading    = true;
+		item->failed     = false;
+		data->generation = ++item->generation;
+		data->entry      = item;
+		texture          = item->texture;
+		failed           = false;
+	}
+
+	data->loader = shared_from_this();
+	data->file   = file;
+	streamfx::threadpool()->push(&decode_handler, data);
+
+	return texture;
+}
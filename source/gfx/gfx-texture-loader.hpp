@@ -0,0 +1,79 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2020 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+
+#pragma once
+#include "common.hpp"
+#include <map>
+#include <mutex>
+#include "obs/gs/gs-texture.hpp"
+#include "util/util-file-watcher.hpp"
+
+// OBS
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/image-file.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+/* gfx::texture_loader loads image files without stalling the graphics thread.
+ *
+ * Files are decoded on the global thread pool and uploaded on the next graphics tick. Textures are shared between
+ *  all users of the same file. Every file is watched through util::file_watcher, and loaded again as a new texture
+ *  once it changes, so asking for a texture never touches the file system.
+ */
+
+namespace gfx {
+	class texture_loader : public std::enable_shared_from_this<gfx::texture_loader> {
+		struct entry {
+			std::shared_ptr<util::file_watcher::handle> watch;
+			std::shared_ptr<gs_image_file_t>            image;
+			uint64_t                                    image_generation;
+			std::shared_ptr<gs::texture>                texture;
+			uint64_t                                    generation; // Increased for every attempt to load the file.
+			bool                                        loading;
+			bool                                        failed;
+			uint64_t                                    last_used;
+		};
+
+		std::mutex                                    _lock;
+		std::map<std::string, std::shared_ptr<entry>> _cache;
+		uint64_t                                      _frame;
+
+		static void tick_handler(void* ptr, float_t time) noexcept;
+		static void decode_handler(std::shared_ptr<void> data) noexcept;
+
+		public: // Singleton
+		static void                                  initialize();
+		static void                                  finalize();
+		static std::shared_ptr<gfx::texture_loader> get();
+
+		public:
+		texture_loader();
+		~texture_loader();
+
+		// Request the texture for an image file, meant to be called again on every tick.
+		//
+		// Returns nullptr while the file is loaded for the first time, in which case the caller should keep showing
+		//  whatever it showed before. While a changed file is loaded again, the previous texture is returned. If the
+		//  file could not be loaded, nullptr is returned and failed is set, until the file changes again.
+		std::shared_ptr<gs::texture> load(const std::string& file, bool& failed);
+	};
+} // namespace gfx
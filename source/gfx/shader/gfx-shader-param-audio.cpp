@@ -0,0 +1,414 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-shader-param-audio.hpp"
+#include <atomic>
+#include <mutex>
+#include "obs/obs-source-tracker.hpp"
+#include "obs/obs-tools.hpp"
+#include "plugin.hpp"
+
+// Samples kept per channel, must be a power of two and larger than the FFT.
+#define ST_RING_SIZE 8192
+// Samples per FFT, must be a power of two.
+#define ST_FFT_SIZE 2048
+// Lowest frequency shown in the spectrum.
+#define ST_FFT_LOWEST 20.0
+// Range of the spectrum in decibel.
+#define ST_FFT_RANGE 90.0
+
+static const std::string_view _annotation_audio_mode = "audio_mode";
+static const std::string_view _annotation_audio_size = "audio_size";
+
+namespace {
+	// One pass of butterflies over two halves of a block. The halves never overlap, which the compiler can't prove
+	//  on its own, and without '__restrict' it gives up on vectorizing the loop.
+	void butterfly(float* __restrict a_re, float* __restrict a_im, float* __restrict b_re, float* __restrict b_im,
+				   const float* w_re, const float* w_im, std::size_t span)
+	{
+		for (std::size_t idx = 0; idx < span; idx++) {
+			float t_re = b_re[idx] * w_re[idx] - b_im[idx] * w_im[idx];
+			float t_im = b_re[idx] * w_im[idx] + b_im[idx] * w_re[idx];
+			b_re[idx]  = a_re[idx] - t_re;
+			b_im[idx]  = a_im[idx] - t_im;
+			a_re[idx]  = a_re[idx] + t_re;
+			a_im[idx]  = a_im[idx] + t_im;
+		}
+	}
+
+	/** Real to complex FFT of a fixed power of two size.
+	 *
+	 * The input is packed into a complex sequence of half the size, transformed with an iterative radix-2 FFT and
+	 * then split into the real spectrum. All tables are precomputed, so a transform does not allocate. Real and
+	 * imaginary parts are kept in separate arrays, as std::complex multiplication goes through __mulsc3 for its NaN
+	 * handling and keeps the butterflies from being vectorized.
+	 */
+	class real_fft {
+		std::size_t              _size;
+		std::vector<std::size_t> _reverse;
+		std::vector<float>       _twiddle_re; // One contiguous table per pass, the pass of length 'len' at 'len/2-1'.
+		std::vector<float>       _twiddle_im;
+		std::vector<float>       _split_re;
+		std::vector<float>       _split_im;
+		std::vector<float>       _work_re;
+		std::vector<float>       _work_im;
+
+		public:
+		real_fft(std::size_t size) : _size(size)
+		{
+			const std::size_t half = _size / 2;
+
+			// Bit reversal permutation for the half-size complex FFT.
+			std::size_t bits = 0;
+			while ((std::size_t{1} << bits) < half) {
+				bits++;
+			}
+			_reverse.resize(half);
+			for (std::size_t idx = 0; idx < half; idx++) {
+				std::size_t rev = 0;
+				for (std::size_t bit = 0; bit < bits; bit++) {
+					rev |= ((idx >> bit) & 1) << (bits - 1 - bit);
+				}
+				_reverse[idx] = rev;
+			}
+
+			_twiddle_re.resize(half);
+			_twiddle_im.resize(half);
+			for (std::size_t len = 2; len <= half; len <<= 1) {
+				for (std::size_t idx = 0; idx < len / 2; idx++) {
+					double_t angle                = -2.0 * S_PI * idx / len;
+					_twiddle_re[len / 2 - 1 + idx] = static_cast<float>(cos(angle));
+					_twiddle_im[len / 2 - 1 + idx] = static_cast<float>(sin(angle));
+				}
+			}
+
+			_split_re.resize(half);
+			_split_im.resize(half);
+			for (std::size_t idx = 0; idx < half; idx++) {
+				double_t angle = -2.0 * S_PI * idx / _size;
+				_split_re[idx] = static_cast<float>(cos(angle));
+				_split_im[idx] = static_cast<float>(sin(angle));
+			}
+
+			_work_re.resize(half);
+			_work_im.resize(half);
+		}
+
+		inline std::size_t size()
+		{
+			return _size;
+		}
+
+		// Transform 'size()' real samples into 'size() / 2 + 1' squared magnitudes.
+		void power(const float* samples, float* out)
+		{
+			const std::size_t half = _size / 2;
+			float*            re   = _work_re.data();
+			float*            im   = _work_im.data();
+
+			// Pack even and odd samples as one complex value, in bit reversed order.
+			for (std::size_t idx = 0; idx < half; idx++) {
+				re[_reverse[idx]] = samples[idx * 2];
+				im[_reverse[idx]] = samples[idx * 2 + 1];
+			}
+
+			// Butterflies.
+			for (std::size_t len = 2; len <= half; len <<= 1) {
+				const std::size_t span = len / 2;
+				const float*      w_re = _twiddle_re.data() + span - 1;
+				const float*      w_im = _twiddle_im.data() + span - 1;
+				for (std::size_t base = 0; base < half; base += len) {
+					butterfly(re + base, im + base, re + base + span, im + base + span, w_re, w_im, span);
+				}
+			}
+
+			// Split into the spectrum of the real input. DC and nyquist only depend on the first value.
+			out[0]    = (re[0] + im[0]) * (re[0] + im[0]);
+			out[half] = (re[0] - im[0]) * (re[0] - im[0]);
+			for (std::size_t idx = 1; idx < half; idx++) {
+				// Z[k] and conj(Z[N-k]) give the transforms of the even and odd samples.
+				float z_re  = re[idx];
+				float z_im  = im[idx];
+				float c_re  = re[half - idx];
+				float c_im  = -im[half - idx];
+				float ev_re = (z_re + c_re) * 0.5f;
+				float ev_im = (z_im + c_im) * 0.5f;
+				float od_re = (z_im - c_im) * 0.5f;
+				float od_im = (c_re - z_re) * 0.5f;
+				float x_re  = ev_re + _split_re[idx] * od_re - _split_im[idx] * od_im;
+				float x_im  = ev_im + _split_re[idx] * od_im + _split_im[idx] * od_re;
+				out[idx]    = x_re * x_re + x_im * x_im;
+			}
+		}
+	};
+} // namespace
+
+struct gfx::shader::audio_parameter::state {
+	audio_mode  mode;
+	std::size_t bins;
+	std::size_t channels;
+	double_t    sample_rate;
+
+	// Ring of the most recent samples, written only by the audio thread.
+	std::vector<float_t>  ring;
+	std::atomic<uint64_t> head;
+
+	// Owned by whichever worker currently holds 'busy'.
+	std::atomic_bool         busy;
+	uint64_t                 last_head;
+	real_fft                 fft;
+	std::vector<float_t>     window;
+	std::vector<float_t>     samples;
+	std::vector<float_t>     spectrum;
+	std::vector<std::size_t> bin_edges;
+	std::vector<float_t>     back;
+
+	// Finished rows, handed over to the graphics thread.
+	std::mutex           lock;
+	std::vector<float_t> front;
+	bool                 fresh;
+
+	state(audio_mode p_mode, std::size_t p_bins)
+		: mode(p_mode), bins(p_bins), channels(audio_output_get_channels(obs_get_audio())),
+		  sample_rate(static_cast<double_t>(audio_output_get_sample_rate(obs_get_audio()))), head(0), busy(false),
+		  last_head(0), fft(ST_FFT_SIZE), fresh(false)
+	{
+		channels = std::clamp<std::size_t>(channels, 1, MAX_AV_PLANES);
+		ring.resize(ST_RING_SIZE * channels, 0);
+
+		if (mode == audio_mode::Spectrum) {
+			samples.resize(fft.size());
+			spectrum.resize(fft.size() / 2 + 1);
+
+			// Hann window.
+			window.resize(fft.size());
+			for (std::size_t idx = 0; idx < window.size(); idx++) {
+				window[idx] = static_cast<float_t>(0.5 - 0.5 * cos(2.0 * S_PI * idx / (window.size() - 1)));
+			}
+
+			// Log-spaced bin edges, from the lowest frequency up to nyquist.
+			double_t nyquist = sample_rate / 2.0;
+			bin_edges.resize(bins + 1);
+			for (std::size_t idx = 0; idx <= bins; idx++) {
+				double_t freq  = ST_FFT_LOWEST * pow(nyquist / ST_FFT_LOWEST, static_cast<double_t>(idx) / bins);
+				bin_edges[idx] = std::clamp<std::size_t>(static_cast<std::size_t>(freq * fft.size() / sample_rate),
+														 0, fft.size() / 2);
+			}
+		} else {
+			samples.resize(bins);
+		}
+
+		back.resize(bins * channels, 0);
+		front.resize(bins * channels, 0);
+	}
+
+	void push(const struct audio_data* audio, bool muted)
+	{
+		std::size_t frames = audio->frames;
+		std::size_t skip   = 0;
+		if (frames > ST_RING_SIZE) {
+			skip   = frames - ST_RING_SIZE;
+			frames = ST_RING_SIZE;
+		}
+
+		uint64_t pos = head.load(std::memory_order_relaxed);
+		for (std::size_t ch = 0; ch < channels; ch++) {
+			float_t*       dst = ring.data() + ST_RING_SIZE * ch;
+			const float_t* src = reinterpret_cast<const float_t*>(audio->data[ch]);
+			for (std::size_t idx = 0; idx < frames; idx++) {
+				dst[(pos + idx) & (ST_RING_SIZE - 1)] = (src && !muted) ? src[skip + idx] : 0;
+			}
+		}
+		head.store(pos + frames, std::memory_order_release);
+	}
+
+	// Copy the most recent samples of a channel, returns false if the audio thread overwrote them meanwhile.
+	bool read(std::size_t channel, uint64_t end, float_t* out, std::size_t count)
+	{
+		const float_t* src = ring.data() + ST_RING_SIZE * channel;
+		for (std::size_t idx = 0; idx < count; idx++) {
+			uint64_t pos = end - count + idx;
+			out[idx]     = (end >= count - idx) ? src[pos & (ST_RING_SIZE - 1)] : 0;
+		}
+		return (head.load(std::memory_order_acquire) - end) <= (ST_RING_SIZE - count);
+	}
+
+	bool process()
+	{
+		uint64_t end = head.load(std::memory_order_acquire);
+
+		for (std::size_t ch = 0; ch < channels; ch++) {
+			float_t* row = back.data() + bins * ch;
+
+			if (!read(ch, end, samples.data(), samples.size())) {
+				return false;
+			}
+
+			if (mode == audio_mode::Waveform) {
+				std::copy(samples.begin(), samples.end(), row);
+				continue;
+			}
+
+			for (std::size_t idx = 0; idx < samples.size(); idx++) {
+				samples[idx] *= window[idx];
+			}
+			fft.power(samples.data(), spectrum.data());
+
+			// Peak of each log-spaced bin, scaled to full-scale power and mapped onto the decibel range.
+			const float_t scale = 16.0f / static_cast<float_t>(fft.size() * fft.size());
+			for (std::size_t idx = 0; idx < bins; idx++) {
+				std::size_t first = bin_edges[idx];
+				std::size_t last  = std::max(bin_edges[idx + 1], first + 1);
+				float_t     peak  = 0;
+				for (std::size_t bin = first; (bin < last) && (bin < spectrum.size()); bin++) {
+					peak = std::max(peak, spectrum[bin]);
+				}
+				double_t db = 10.0 * log10(std::max<double_t>(peak * scale, 1e-18));
+				row[idx]    = static_cast<float_t>(std::clamp((db + ST_FFT_RANGE) / ST_FFT_RANGE, 0.0, 1.0));
+			}
+		}
+
+		std::unique_lock<std::mutex> ul(lock);
+		front.swap(back);
+		fresh = true;
+		return true;
+	}
+};
+
+static void audio_process_handler(std::shared_ptr<void> data) noexcept
+{
+	auto s = std::static_pointer_cast<gfx::shader::audio_parameter::state>(data);
+	try {
+		s->process();
+	} catch (...) {
+		DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+	}
+	s->busy.store(false, std::memory_order_release);
+}
+
+gfx::shader::audio_mode gfx::shader::get_audio_mode_from_string(std::string v)
+{
+	if (v == "waveform") {
+		return audio_mode::Waveform;
+	}
+	return audio_mode::Spectrum;
+}
+
+gfx::shader::audio_parameter::audio_parameter(gs::effect_parameter param, std::string prefix)
+	: parameter(param, prefix), _mode(audio_mode::Spectrum), _bins(0), _source_name(), _source_audio(), _state(),
+	  _texture()
+{
+	if (auto anno = get_parameter().get_annotation(_annotation_audio_mode); anno) {
+		_mode = get_audio_mode_from_string(anno.get_default_string());
+	}
+
+	_bins = (_mode == audio_mode::Waveform) ? 512 : 128;
+	if (auto anno = get_parameter().get_annotation(_annotation_audio_size); anno) {
+		if (int32_t v = anno.get_default_int(); v > 0) {
+			_bins = static_cast<uint32_t>(v);
+		}
+	}
+	_bins = std::clamp<uint32_t>(_bins, 8, (_mode == audio_mode::Waveform) ? ST_FFT_SIZE : ST_FFT_SIZE / 2);
+}
+
+gfx::shader::audio_parameter::~audio_parameter()
+{
+	// Stop capturing before the state goes away.
+	_source_audio.reset();
+}
+
+void gfx::shader::audio_parameter::defaults(obs_data_t* settings)
+{
+	obs_data_set_default_string(settings, get_key().data(), "");
+}
+
+void gfx::shader::audio_parameter::properties(obs_properties_t* props, obs_data_t* settings)
+{
+	if (!is_visible())
+		return;
+
+	auto p = obs_properties_add_list(props, get_key().data(), get_name().data(), OBS_COMBO_TYPE_LIST,
+									 OBS_COMBO_FORMAT_STRING);
+	if (has_description())
+		obs_property_set_long_description(p, get_description().data());
+
+	obs_property_list_add_string(p, "", "");
+	obs::source_tracker::get()->enumerate(
+		[&p](std::string name, obs_source_t*) {
+			obs_property_list_add_string(p, name.c_str(), name.c_str());
+			return false;
+		},
+		obs::source_tracker::source_kind::AudioInput);
+}
+
+void gfx::shader::audio_parameter::update(obs_data_t* settings)
+{
+	std::string name = obs_data_get_string(settings, get_key().data());
+	if (name == _source_name)
+		return;
+
+	_source_name = name;
+	_source_audio.reset();
+	std::atomic_store(&_state, std::shared_ptr<state>());
+
+	if (name.length() == 0)
+		return;
+
+	std::shared_ptr<obs_source_t> source{obs_get_source_by_name(name.c_str()), obs::obs_source_deleter};
+	if (!source)
+		return;
+
+	auto s        = std::make_shared<state>(_mode, _bins);
+	_source_audio = std::make_shared<obs::audio_signal_handler>(source);
+	_source_audio->event.add(
+		[s](std::shared_ptr<obs_source_t>, const struct audio_data* audio, bool muted) { s->push(audio, muted); });
+	std::atomic_store(&_state, s);
+}
+
+void gfx::shader::audio_parameter::assign()
+{
+	auto s = std::atomic_load(&_state);
+	if (!s) {
+		get_parameter().set_texture(nullptr);
+		return;
+	}
+
+	// Queue the next update if there is new audio and no update in flight.
+	if (uint64_t head = s->head.load(std::memory_order_acquire); head != s->last_head) {
+		if (!s->busy.exchange(true, std::memory_order_acq_rel)) {
+			s->last_head = head;
+			streamfx::threadpool()->push(audio_process_handler, s, util::threadpool_priority::Realtime);
+		}
+	}
+
+	// Upload the finished rows, if any.
+	{
+		std::unique_lock<std::mutex> ul(s->lock);
+		if (s->fresh) {
+			if (!_texture || (_texture->get_width() != s->bins) || (_texture->get_height() != s->channels)) {
+				_texture = std::make_shared<gs::texture>(static_cast<uint32_t>(s->bins),
+														 static_cast<uint32_t>(s->channels), GS_R32F, 1, nullptr,
+														 gs::texture::flags::Dynamic);
+			}
+			gs_texture_set_image(_texture->get_object(), reinterpret_cast<const uint8_t*>(s->front.data()),
+								 static_cast<uint32_t>(s->bins * sizeof(float_t)), false);
+			s->fresh = false;
+		}
+	}
+
+	get_parameter().set_texture(_texture ? _texture->get_object() : nullptr);
+}
@@ -0,0 +1,66 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include "gfx-shader-param.hpp"
+#include "obs/gs/gs-texture.hpp"
+#include "obs/obs-signal-handler.hpp"
+
+namespace gfx {
+	namespace shader {
+		enum class audio_mode {
+			// Most recent samples, -1.0 to 1.0.
+			Waveform,
+			// Log-spaced spectrum bins, 0.0 (-90dB) to 1.0 (0dB).
+			Spectrum,
+		};
+
+		audio_mode get_audio_mode_from_string(std::string v);
+
+		/** Exposes the audio of a source as a R32F texture, one row per channel.
+		 *
+		 * Audio is captured into a lock-free ring on the audio thread, and the spectrum is calculated on the
+		 * global thread pool. The graphics thread only ever uploads the finished rows.
+		 */
+		class audio_parameter : public parameter {
+			public:
+			struct state;
+
+			private:
+			audio_mode _mode;
+			uint32_t   _bins;
+
+			std::string                                _source_name;
+			std::shared_ptr<obs::audio_signal_handler> _source_audio;
+			std::shared_ptr<state>                     _state;
+			std::shared_ptr<gs::texture>               _texture;
+
+			public:
+			audio_parameter(gs::effect_parameter param, std::string prefix);
+			virtual ~audio_parameter();
+
+			void defaults(obs_data_t* settings) override;
+
+			void properties(obs_properties_t* props, obs_data_t* settings) override;
+
+			void update(obs_data_t* settings) override;
+
+			void assign() override;
+		};
+	} // namespace shader
+} // namespace gfx
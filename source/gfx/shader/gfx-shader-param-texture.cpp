@@ -0,0 +1,197 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-shader-param-texture.hpp"
+#include <sstream>
+#include "gfx/gfx-texture-loader.hpp"
+#include "obs/obs-source-tracker.hpp"
+
+#define ST "Shader.Parameter.Texture"
+#define ST_TYPE ST ".Type"
+#define ST_FILE ST ".File"
+#define ST_SOURCE ST ".Source"
+
+static const std::string_view _annotation_max_size = "max_size";
+
+gfx::shader::texture_parameter::texture_parameter(gs::effect_parameter param, std::string prefix, obs_source_t* self)
+	: parameter(param, prefix), _self(self), _max_size(0), _key_type(), _key_file(), _key_source(), _lock(),
+	  _type(texture_field_type::File), _file(), _source(), _file_loaded(), _file_texture(), _source_loaded(),
+	  _source_texture()
+{
+	_key_type   = std::string(get_key()) + ".Type";
+	_key_file   = std::string(get_key()) + ".File";
+	_key_source = std::string(get_key()) + ".Source";
+
+	if (auto anno = get_parameter().get_annotation(_annotation_max_size); anno) {
+		if (int32_t v = anno.get_default_int(); v > 0) {
+			_max_size = static_cast<uint32_t>(v);
+		}
+	}
+}
+
+gfx::shader::texture_parameter::~texture_parameter() {}
+
+void gfx::shader::texture_parameter::defaults(obs_data_t* settings)
+{
+	obs_data_set_default_int(settings, _key_type.c_str(), static_cast<int64_t>(texture_field_type::File));
+	obs_data_set_default_string(settings, _key_file.c_str(), "");
+	obs_data_set_default_string(settings, _key_source.c_str(), "");
+}
+
+void gfx::shader::texture_parameter::properties(obs_properties_t* props, obs_data_t* settings)
+{
+	if (!is_visible())
+		return;
+
+	obs_properties_t* pr = obs_properties_create();
+	{
+		auto p = obs_properties_add_group(props, get_key().data(), has_name() ? get_name().data() : get_key().data(),
+										  OBS_GROUP_NORMAL, pr);
+		if (has_description())
+			obs_property_set_long_description(p, get_description().data());
+	}
+
+	{
+		auto p = obs_properties_add_list(pr, _key_type.c_str(), D_TRANSLATE(ST_TYPE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(S_FILETYPE_IMAGE), static_cast<int64_t>(texture_field_type::File));
+		obs_property_list_add_int(p, D_TRANSLATE(S_SOURCETYPE_SOURCE),
+								  static_cast<int64_t>(texture_field_type::Source));
+	}
+
+	{
+		std::stringstream filter;
+		filter << D_TRANSLATE(S_FILETYPE_IMAGES) << " (" << S_FILEFILTERS_TEXTURE << ");;* (*.*)";
+		obs_properties_add_path(pr, _key_file.c_str(), D_TRANSLATE(ST_FILE), OBS_PATH_FILE, filter.str().c_str(),
+								nullptr);
+	}
+
+	{
+		auto p = obs_properties_add_list(pr, _key_source.c_str(), D_TRANSLATE(ST_SOURCE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_STRING);
+		obs_property_list_add_string(p, "", "");
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				std::stringstream sstr;
+				sstr << name << " (" << D_TRANSLATE(S_SOURCETYPE_SOURCE) << ")";
+				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::source_kind::VideoInput);
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				std::stringstream sstr;
+				sstr << name << " (" << D_TRANSLATE(S_SOURCETYPE_SCENE) << ")";
+				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::source_kind::Scene);
+	}
+}
+
+void gfx::shader::texture_parameter::update(obs_data_t* settings)
+{
+	std::unique_lock<std::mutex> ul(_lock);
+	_type   = static_cast<texture_field_type>(obs_data_get_int(settings, _key_type.c_str()));
+	_file   = obs_data_get_string(settings, _key_file.c_str());
+	_source = obs_data_get_string(settings, _key_source.c_str());
+}
+
+void gfx::shader::texture_parameter::assign()
+{
+	// Automatic textures, like the inputs, are provided by the shader host.
+	if (is_automatic())
+		return;
+
+	texture_field_type type;
+	std::string        name;
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+		type = _type;
+		name = (type == texture_field_type::Source) ? _source : _file;
+	}
+
+	std::shared_ptr<gs::texture> texture;
+	try {
+		if (type == texture_field_type::Source) {
+			_file_texture.reset();
+			_file_loaded.clear();
+			texture = render_source(name);
+		} else {
+			_source_texture.reset();
+			_source_loaded.clear();
+			texture = render_file(name);
+		}
+	} catch (const std::exception& ex) {
+		DLOG_ERROR("Texture parameter '%s' failed to update with error: %s", get_key().data(), ex.what());
+	}
+
+	get_parameter().set_texture(texture ? texture->get_object() : nullptr);
+}
+
+std::shared_ptr<gs::texture> gfx::shader::texture_parameter::render_file(std::string file)
+{
+	if (file.length() == 0) {
+		_file_texture.reset();
+		_file_loaded = file;
+	} else {
+		// Keep the previous image until the new one has been loaded in the background.
+		bool failed = false;
+		if (auto texture = gfx::texture_loader::get()->load(file, failed); texture) {
+			_file_texture = texture;
+			_file_loaded  = file;
+		} else if (failed) {
+			_file_texture.reset();
+			if (file != _file_loaded) {
+				_file_loaded = file;
+				throw std::runtime_error("Failed to load texture '" + file + "'.");
+			}
+		}
+	}
+
+	return _file_texture;
+}
+
+std::shared_ptr<gs::texture> gfx::shader::texture_parameter::render_source(std::string source)
+{
+	if (source != _source_loaded) {
+		_source_texture.reset();
+		_source_loaded = source;
+		if (source.length() > 0) {
+			_source_texture = std::make_shared<gfx::source_texture>(source, _self);
+		}
+	}
+
+	if (!_source_texture) {
+		return nullptr;
+	}
+
+	uint32_t width  = obs_source_get_width(_source_texture->get_object());
+	uint32_t height = obs_source_get_height(_source_texture->get_object());
+	if ((width == 0) || (height == 0)) {
+		return nullptr;
+	}
+
+	// Scale the longest side down to the cap, keeping the aspect ratio. The whole source is drawn into the capture.
+	if ((_max_size > 0) && (std::max(width, height) > _max_size)) {
+		double_t scale = static_cast<double_t>(_max_size) / static_cast<double_t>(std::max(width, height));
+		width          = std::max<uint32_t>(1, static_cast<uint32_t>(width * scale));
+		height         = std::max<uint32_t>(1, static_cast<uint32_t>(height * scale));
+	}
+
+	return _source_texture->render(width, height);
+}
@@ -0,0 +1,78 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <mutex>
+#include "gfx-shader-param.hpp"
+#include "gfx/gfx-source-texture.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+namespace gfx {
+	namespace shader {
+		enum class texture_field_type {
+			File,
+			Source,
+		};
+
+		/** Binds a texture parameter to an image file or a live source.
+		 *
+		 * Sources are captured through the shared source_texture factory, so several parameters or shaders sampling
+		 * the same source at the same size share one capture per frame. The 'max_size' annotation caps the longest
+		 * side of a capture, for shaders that do not need the full resolution of a source.
+		 */
+		class texture_parameter : public parameter {
+			obs_source_t* _self;
+			uint32_t      _max_size;
+
+			std::string _key_type;
+			std::string _key_file;
+			std::string _key_source;
+
+			// Settings, written by update() and read by assign().
+			std::mutex         _lock;
+			texture_field_type _type;
+			std::string        _file;
+			std::string        _source;
+
+			// File
+			std::string                  _file_loaded;
+			std::shared_ptr<gs::texture> _file_texture;
+
+			// Source
+			std::string                          _source_loaded;
+			std::shared_ptr<gfx::source_texture> _source_texture;
+
+			public:
+			texture_parameter(gs::effect_parameter param, std::string prefix, obs_source_t* self);
+			virtual ~texture_parameter();
+
+			void defaults(obs_data_t* settings) override;
+
+			void properties(obs_properties_t* props, obs_data_t* settings) override;
+
+			void update(obs_data_t* settings) override;
+
+			void assign() override;
+
+			private:
+			std::shared_ptr<gs::texture> render_file(std::string file);
+
+			std::shared_ptr<gs::texture> render_source(std::string source);
+		};
+	} // namespace shader
+} // namespace gfx
@@ -18,7 +18,9 @@
 #include "gfx-shader-param.hpp"
 #include <algorithm>
 #include <sstream>
+#include "gfx-shader-param-audio.hpp"
 #include "gfx-shader-param-basic.hpp"
+#include "gfx-shader-param-texture.hpp"
 
 #define ANNO_ORDER "order"
 #define ANNO_VISIBILITY "visible"
@@ -102,6 +104,9 @@ gfx::shader::parameter_type gfx::shader::get_type_from_string(std::string v)
 	if ((v == "sampler")) {
 		return parameter_type::Sampler;
 	}
+	if ((v == "audio")) {
+		return parameter_type::Audio;
+	}
 	/* To decide on in the future:
 	 * - Double support?
 	 * - Half Support?
@@ -176,7 +181,8 @@ void gfx::shader::parameter::update(obs_data_t* settings) {}
 void gfx::shader::parameter::assign() {}
 
 std::shared_ptr<gfx::shader::parameter> gfx::shader::parameter::make_parameter(gs::effect_parameter param,
-																			   std::string          prefix)
+																			   std::string          prefix,
+																			   obs_source_t*        self)
 {
 	if (!param) {
 		throw std::runtime_error("Bad call to make_parameter. This is a bug in the plugin.");
@@ -185,7 +191,7 @@ std::shared_ptr<gfx::shader::parameter> gfx::shader::parameter::make_parameter(g
 	parameter_type real_type = get_type_from_effect_type(param.get_type());
 	if (auto anno = param.get_annotation(ANNO_TYPE); anno) {
 		// We have a type override.
-		real_type = get_type_from_string(param.get_default_string());
+		real_type = get_type_from_string(anno.get_default_string());
 	}
 
 	switch (real_type) {
@@ -195,6 +201,10 @@ std::shared_ptr<gfx::shader::parameter> gfx::shader::parameter::make_parameter(g
 		return std::make_shared<gfx::shader::int_parameter>(param, prefix);
 	case parameter_type::Float:
 		return std::make_shared<gfx::shader::float_parameter>(param, prefix);
+	case parameter_type::Texture:
+		return std::make_shared<gfx::shader::texture_parameter>(param, prefix, self);
+	case parameter_type::Audio:
+		return std::make_shared<gfx::shader::audio_parameter>(param, prefix);
 	default:
 		return nullptr;
 	}
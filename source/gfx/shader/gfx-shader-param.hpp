@@ -36,7 +36,9 @@ namespace gfx {
 			// Texture with dimensions stored in size (1 = Texture1D, 2 = Texture2D, 3 = Texture3D, 6 = TextureCube).
 			Texture,
 			// Sampler for Textures.
-			Sampler
+			Sampler,
+			// Texture containing the waveform or spectrum of an audio source.
+			Audio
 		};
 
 		parameter_type get_type_from_effect_type(gs::effect_parameter::type type);
@@ -137,7 +139,8 @@ namespace gfx {
 			}
 
 			public:
-			static std::shared_ptr<parameter> make_parameter(gs::effect_parameter param, std::string prefix);
+			static std::shared_ptr<parameter> make_parameter(gs::effect_parameter param, std::string prefix,
+															 obs_source_t* self);
 		};
 	} // namespace shader
 } // namespace gfx
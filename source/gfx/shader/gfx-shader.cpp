@@ -33,16 +33,41 @@
 #define ST_SHADER_SEED ST_SHADER ".Seed"
 #define ST_PARAMETERS ST ".Parameters"
 
+#define ANNO_BUFFER_TECHNIQUE "buffer_technique"
+#define ANNO_BUFFER_SCALE "buffer_scale"
+#define ANNO_BUFFER_FORMAT "buffer_format"
+
+static gs_color_format get_format_from_string(std::string v)
+{
+	if (v == "r8") {
+		return GS_R8;
+	} else if (v == "r16f") {
+		return GS_R16F;
+	} else if (v == "r32f") {
+		return GS_R32F;
+	} else if (v == "rg16f") {
+		return GS_RG16F;
+	} else if (v == "rg32f") {
+		return GS_RG32F;
+	} else if (v == "rgba16f") {
+		return GS_RGBA16F;
+	} else if (v == "rgba32f") {
+		return GS_RGBA32F;
+	}
+	return GS_RGBA;
+}
+
 gfx::shader::shader::shader(obs_source_t* self, shader_mode mode)
 	: _self(self), _mode(mode), _base_width(1), _base_height(1), _active(true),
 
-	  _shader(), _shader_file(), _shader_tech("Draw"), _shader_file_mt(), _shader_file_sz(), _shader_file_tick(0),
+	  _shader(), _shader_file(), _shader_tech("Draw"), _shader_file_mt(), _shader_file_sz(), _shader_file_watch(),
+	  _shader_buffers(), _shader_buffers_dirty(true),
 
 	  _width_type(size_type::Percent), _width_value(1.0), _height_type(size_type::Percent), _height_value(1.0),
 
 	  _have_current_params(false), _time(0), _time_loop(0), _loops(0), _random(), _random_seed(0),
 
-	  _rt_up_to_date(false), _rt(std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE))
+	  _rt_up_to_date(false), _rt_dynamic(true), _rt(std::make_shared<gs::rendertarget>(GS_RGBA, GS_ZS_NONE))
 {
 	// Intialize random values.
 	_random.seed(static_cast<unsigned long long>(_random_seed));
@@ -90,6 +115,14 @@ bool gfx::shader::shader::is_technique_different(const std::string& tech)
 bool gfx::shader::shader::load_shader(const std::filesystem::path& file, const std::string& tech, bool& shader_dirty,
 									  bool& param_dirty)
 try {
+	// Watch the file as soon as it is known, so that a shader which is missing or fails to compile is loaded again
+	//  once the file is fixed.
+	if (!file.empty()) {
+		auto path = std::filesystem::absolute(file).lexically_normal();
+		if (!_shader_file_watch || (_shader_file_watch->path() != path))
+			_shader_file_watch = util::file_watcher::get()->watch(path);
+	}
+
 	if (!std::filesystem::exists(file))
 		return false;
 
@@ -98,11 +131,32 @@ try {
 
 	// Update Shader
 	if (shader_dirty) {
-		_shader           = gs::effect(file);
-		_shader_file_mt   = std::filesystem::last_write_time(file);
-		_shader_file_sz   = std::filesystem::file_size(file);
-		_shader_file      = file;
-		_shader_file_tick = 0;
+		// Not shared with other instances, as parameters are assigned while other sources (which may use the same
+		//  file) render, and buffer passes may read parameters set long before them.
+		_shader         = gs::effect(file);
+		_shader_file_mt = std::filesystem::last_write_time(file);
+		_shader_file_sz = std::filesystem::file_size(file);
+		_shader_file    = file;
+
+		// Resolve well-known parameters now, instead of searching for them every frame.
+		auto find_known = [this](std::initializer_list<const char*> names, gs::effect_parameter::type type) {
+			for (auto name : names) {
+				if (gs::effect_parameter el = _shader.get_parameter(name); el != nullptr) {
+					if (el.get_type() == type) {
+						return el;
+					}
+				}
+			}
+			return gs::effect_parameter();
+		};
+		_shader_known.time            = find_known({"Time"}, gs::effect_parameter::type::Float4);
+		_shader_known.view_size       = find_known({"ViewSize"}, gs::effect_parameter::type::Float4);
+		_shader_known.random          = find_known({"Random"}, gs::effect_parameter::type::Matrix);
+		_shader_known.random_seed     = find_known({"RandomSeed"}, gs::effect_parameter::type::Integer);
+		_shader_known.input_a         = find_known({"InputA", "image", "tex_a"}, gs::effect_parameter::type::Texture);
+		_shader_known.input_b         = find_known({"InputB", "image2", "tex_b"}, gs::effect_parameter::type::Texture);
+		_shader_known.transition_time = find_known({"TransitionTime"}, gs::effect_parameter::type::Float);
+		_shader_known.transition_size = find_known({"TransitionSize"}, gs::effect_parameter::type::Integer2);
 	}
 
 	// Update Params
@@ -126,52 +180,135 @@ try {
 			obs_data_set_string(settings.get(), ST_SHADER_TECHNIQUE, _shader_tech.c_str());
 		}
 
-		// Clear the shader parameters map and rebuild.
-		_shader_params.clear();
-		auto etech = _shader.get_technique(_shader_tech);
-		for (std::size_t idx = 0; idx < etech.count_passes(); idx++) {
-			auto pass = etech.get_pass(idx);
+		// Find declared buffers, which are textures rendered by their own technique before the selected one.
+		_shader_buffers.clear();
+		for (std::size_t idx = 0; idx < _shader.count_parameters(); idx++) {
+			auto el = _shader.get_parameter(idx);
+			if (!el || (el.get_type() != gs::effect_parameter::type::Texture))
+				continue;
+
+			auto anno = el.get_annotation(ANNO_BUFFER_TECHNIQUE);
+			if (!anno)
+				continue;
+
+			shader_buffer buffer;
+			buffer.technique = anno.get_default_string();
+			if (!_shader.get_technique(buffer.technique) || (buffer.technique == _shader_tech)) {
+				DLOG_ERROR("Buffer '%s' uses invalid technique '%s'.", el.get_name().data(), buffer.technique.c_str());
+				continue;
+			}
+			buffer.param  = el;
+			buffer.scale  = 1.0f;
+			buffer.format = GS_RGBA;
+			if (auto anno_scale = el.get_annotation(ANNO_BUFFER_SCALE); anno_scale) {
+				buffer.scale = std::clamp(anno_scale.get_default_float(), 1.0f / 16.0f, 4.0f);
+			}
+			if (auto anno_format = el.get_annotation(ANNO_BUFFER_FORMAT); anno_format) {
+				buffer.format = get_format_from_string(anno_format.get_default_string());
+			}
+			buffer.feedback = false;
+			buffer.dynamic  = false;
+			buffer.valid    = false;
+			buffer.width    = 0;
+			buffer.height   = 0;
+			buffer.current  = 0;
+			_shader_buffers.push_back(buffer);
+		}
+		_shader_buffers_dirty = true;
 
-			for (std::size_t vidx = 0; vidx < pass.count_vertex_parameters(); vidx++) {
-				auto el = pass.get_vertex_parameter(vidx);
+		// Clear the shader parameters map and rebuild it from every technique that is drawn.
+		_shader_params.clear();
+		auto collect = [this, &settings](const std::string& technique) {
+			std::set<std::string_view> names;
+			auto                       etech = _shader.get_technique(technique);
 
+			auto add = [this, &settings, &names](gs::effect_parameter el) {
 				if (!el)
-					continue;
+					return;
+
+				names.insert(el.get_name());
+
+				// Buffers are provided by the shader itself.
+				for (auto& buffer : _shader_buffers) {
+					if (buffer.param.get_name() == el.get_name())
+						return;
+				}
 
 				auto fnd = _shader_params.find(el.get_name());
 				if (fnd != _shader_params.end())
-					continue;
+					return;
 
-				auto param = gfx::shader::parameter::make_parameter(el, ST_PARAMETERS);
+				auto param = gfx::shader::parameter::make_parameter(el, ST_PARAMETERS, _self);
 
 				if (param) {
 					_shader_params.insert_or_assign(el.get_name(), param);
 					param->defaults(settings.get());
 					param->update(settings.get());
 				}
-			}
+			};
 
-			for (std::size_t vidx = 0; vidx < pass.count_pixel_parameters(); vidx++) {
-				auto el = pass.get_pixel_parameter(vidx);
+			for (std::size_t idx = 0; idx < etech.count_passes(); idx++) {
+				auto pass = etech.get_pass(idx);
 
-				if (!el)
-					continue;
+				for (std::size_t vidx = 0; vidx < pass.count_vertex_parameters(); vidx++) {
+					add(pass.get_vertex_parameter(vidx));
+				}
 
-				auto fnd = _shader_params.find(el.get_name());
-				if (fnd != _shader_params.end())
-					continue;
+				for (std::size_t vidx = 0; vidx < pass.count_pixel_parameters(); vidx++) {
+					add(pass.get_pixel_parameter(vidx));
+				}
+			}
 
-				auto param = gfx::shader::parameter::make_parameter(el, ST_PARAMETERS);
+			return names;
+		};
 
-				if (param) {
-					_shader_params.insert_or_assign(el.get_name(), param);
-					param->defaults(settings.get());
-					param->update(settings.get());
+		auto names = collect(_shader_tech);
+		std::vector<std::set<std::string_view>> buffer_names;
+		for (auto& buffer : _shader_buffers) {
+			buffer_names.push_back(collect(buffer.technique));
+		}
+
+		// Anything that changes every frame forces a buffer to be redrawn every frame, everything else only
+		//  changes with the settings or the size.
+		std::set<std::string_view> dynamic_names = {"Time", "Random", "TransitionTime"};
+		for (auto el : {_shader_known.input_a, _shader_known.input_b}) {
+			if (el)
+				dynamic_names.insert(el.get_name());
+		}
+		for (auto kv : _shader_params) {
+			if ((kv.second->get_type() == parameter_type::Texture) || (kv.second->get_type() == parameter_type::Audio))
+				dynamic_names.insert(kv.first);
+		}
+		for (std::size_t idx = 0; idx < _shader_buffers.size(); idx++) {
+			auto& buffer = _shader_buffers[idx];
+
+			buffer.feedback = (buffer_names[idx].count(buffer.param.get_name()) > 0);
+			buffer.dynamic  = buffer.feedback;
+			for (auto name : buffer_names[idx]) {
+				if (dynamic_names.count(name) > 0)
+					buffer.dynamic = true;
+
+				// Buffers that are drawn later are only available from the previous frame.
+				for (std::size_t later = idx + 1; later < _shader_buffers.size(); later++) {
+					if (_shader_buffers[later].param.get_name() == name)
+						buffer.dynamic = true;
 				}
 			}
+
+			if (buffer.dynamic)
+				dynamic_names.insert(buffer.param.get_name());
+		}
+
+		// Same for the selected technique, which otherwise only needs to be drawn again when something changes.
+		_rt_dynamic = false;
+		for (auto name : names) {
+			if (dynamic_names.count(name) > 0)
+				_rt_dynamic = true;
 		}
 	}
 
+	_rt_up_to_date = false;
+
 	return true;
 } catch (const std::exception& ex) {
 	DLOG_ERROR("Loading shader '%s' failed with error: %s", file.c_str(), ex.what());
@@ -373,6 +510,9 @@ void gfx::shader::shader::update(obs_data_t* data)
 	for (auto kv : _shader_params) {
 		kv.second->update(data);
 	}
+
+	_shader_buffers_dirty = true;
+	_rt_up_to_date        = false;
 }
 
 uint32_t gfx::shader::shader::width()
@@ -435,11 +575,9 @@ uint32_t gfx::shader::shader::base_height()
 
 bool gfx::shader::shader::tick(float_t time)
 {
-	_shader_file_tick = static_cast<float_t>(static_cast<double_t>(_shader_file_tick) + static_cast<double_t>(time));
-	if (_shader_file_tick >= 1.0f / 3.0f) {
-		_shader_file_tick -= 1.0f / 3.0f;
+	if (_shader_file_watch && _shader_file_watch->changed()) {
 		bool v1, v2;
-		load_shader(_shader_file, _shader_tech, v1, v2);
+		load_shader(_shader_file_watch->path(), _shader_tech, v1, v2);
 	}
 
 	// Update State
@@ -473,37 +611,32 @@ void gfx::shader::shader::prepare_render()
 	}
 
 	// float4 Time: (Current Time), (Zero), (Zero), (Random Value)
-	if (gs::effect_parameter el = _shader.get_parameter("Time"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Float4) {
-			el.set_float4(
-				_time, _time_loop, static_cast<float_t>(_loops),
-				static_cast<float_t>(static_cast<double_t>(_random()) / static_cast<double_t>(_random.max())));
-		}
+	if (_shader_known.time) {
+		_shader_known.time.set_float4(
+			_time, _time_loop, static_cast<float_t>(_loops),
+			static_cast<float_t>(static_cast<double_t>(_random()) / static_cast<double_t>(_random.max())));
 	}
 
 	// float4 ViewSize: (Width), (Height), (1.0 / Width), (1.0 / Height)
-	if (auto el = _shader.get_parameter("ViewSize"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Float4) {
-			el.set_float4(static_cast<float_t>(width()), static_cast<float_t>(height()),
-						  1.0f / static_cast<float_t>(width()), 1.0f / static_cast<float_t>(height()));
-		}
+	if (_shader_known.view_size) {
+		_shader_known.view_size.set_float4(static_cast<float_t>(width()), static_cast<float_t>(height()),
+										   1.0f / static_cast<float_t>(width()), 1.0f / static_cast<float_t>(height()));
 	}
 
 	// float4x4 Random: float4[Per-Instance Random], float4[Per-Activation Random], float4x2[Per-Frame Random]
-	if (auto el = _shader.get_parameter("Random"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Matrix) {
-			el.set_value(_random_values, 16);
-		}
+	if (_shader_known.random) {
+		_shader_known.random.set_value(_random_values, 16);
 	}
 
 	// int32 RandomSeed: Seed used for random generation
-	if (auto el = _shader.get_parameter("RandomSeed"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Integer) {
-			el.set_int(_random_seed);
-		}
+	if (_shader_known.random_seed) {
+		_shader_known.random_seed.set_int(_random_seed);
 	}
 
-	_rt_up_to_date = false;
+	// Static shaders keep their last result until a setting or the size changes.
+	if (_rt_dynamic) {
+		_rt_up_to_date = false;
+	}
 }
 
 void gfx::shader::shader::render()
@@ -512,6 +645,8 @@ void gfx::shader::shader::render()
 		return;
 
 	if (!_rt_up_to_date) {
+		render_buffers();
+
 		auto op   = _rt->render(width(), height());
 		vec4 zero = {0, 0, 0, 0};
 		gs_ortho(0, 1, 0, 1, 0, 1);
@@ -528,6 +663,8 @@ void gfx::shader::shader::render()
 		}
 
 		gs_blend_state_pop();
+
+		_rt_up_to_date = true;
 	}
 
 	gs_effect_set_texture(gs_effect_get_param_by_name(obs_get_base_effect(OBS_EFFECT_DEFAULT), "image"),
@@ -537,8 +674,83 @@ void gfx::shader::shader::render()
 	}
 }
 
+void gfx::shader::shader::render_buffers()
+{
+	auto buffer_size = [this](const shader_buffer& buffer) {
+		return std::make_pair(std::max<uint32_t>(1, static_cast<uint32_t>(width() * buffer.scale)),
+							  std::max<uint32_t>(1, static_cast<uint32_t>(height() * buffer.scale)));
+	};
+
+	// Bind every buffer before the first pass. Buffers sampling themselves or a buffer drawn after them read its
+	//  previous frame, or nothing if there is none at this size, but never whatever the parameter held before.
+	for (auto& buffer : _shader_buffers) {
+		auto [buffer_width, buffer_height] = buffer_size(buffer);
+
+		bool have_previous = buffer.valid && buffer.rt[buffer.current] && (buffer.width == buffer_width)
+							 && (buffer.height == buffer_height);
+		buffer.param.set_texture(have_previous ? buffer.rt[buffer.current]->get_object() : nullptr);
+	}
+
+	for (auto& buffer : _shader_buffers) {
+		auto [buffer_width, buffer_height] = buffer_size(buffer);
+
+		// Buffers that only depend on settings keep their content until the settings or the size change.
+		if (buffer.valid && !buffer.dynamic && !_shader_buffers_dirty && (buffer.width == buffer_width)
+			&& (buffer.height == buffer_height)) {
+			continue;
+		}
+
+		std::size_t next = buffer.feedback ? (buffer.current ^ 1) : buffer.current;
+		if (!buffer.rt[next]) {
+			buffer.rt[next] = std::make_shared<gs::rendertarget>(buffer.format, GS_ZS_NONE);
+		}
+
+		if (_shader_known.view_size) {
+			_shader_known.view_size.set_float4(static_cast<float_t>(buffer_width), static_cast<float_t>(buffer_height),
+											   1.0f / static_cast<float_t>(buffer_width),
+											   1.0f / static_cast<float_t>(buffer_height));
+		}
+
+		{
+			auto op   = buffer.rt[next]->render(buffer_width, buffer_height);
+			vec4 zero = {0, 0, 0, 0};
+			gs_ortho(0, 1, 0, 1, 0, 1);
+			gs_clear(GS_CLEAR_COLOR, &zero, 0, 0);
+
+			gs_blend_state_push();
+			gs_reset_blend_state();
+
+			gs_enable_blending(true);
+			gs_blend_function_separate(GS_BLEND_ONE, GS_BLEND_ZERO, GS_BLEND_ONE, GS_BLEND_ZERO);
+			gs_enable_color(true, true, true, true);
+			while (gs_effect_loop(_shader.get_object(), buffer.technique.c_str())) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+
+			gs_blend_state_pop();
+		}
+
+		buffer.current = next;
+		buffer.valid   = true;
+		buffer.width   = buffer_width;
+		buffer.height  = buffer_height;
+		buffer.param.set_texture(buffer.rt[buffer.current]->get_object());
+	}
+	_shader_buffers_dirty = false;
+
+	// Restore the view size of the selected technique.
+	if (_shader_known.view_size && (_shader_buffers.size() > 0)) {
+		_shader_known.view_size.set_float4(static_cast<float_t>(width()), static_cast<float_t>(height()),
+										   1.0f / static_cast<float_t>(width()), 1.0f / static_cast<float_t>(height()));
+	}
+}
+
 void gfx::shader::shader::set_size(uint32_t w, uint32_t h)
 {
+	if ((w != _base_width) || (h != _base_height)) {
+		_rt_up_to_date = false;
+	}
+
 	_base_width  = w;
 	_base_height = h;
 }
@@ -548,18 +760,8 @@ void gfx::shader::shader::set_input_a(std::shared_ptr<gs::texture> tex)
 	if (!_shader)
 		return;
 
-	std::string_view params[] = {
-		"InputA",
-		"image",
-		"tex_a",
-	};
-	for (auto& name : params) {
-		if (gs::effect_parameter el = _shader.get_parameter(name.data()); el != nullptr) {
-			if (el.get_type() == gs::effect_parameter::type::Texture) {
-				el.set_texture(tex);
-				break;
-			}
-		}
+	if (_shader_known.input_a) {
+		_shader_known.input_a.set_texture(tex);
 	}
 }
 
@@ -568,18 +770,8 @@ void gfx::shader::shader::set_input_b(std::shared_ptr<gs::texture> tex)
 	if (!_shader)
 		return;
 
-	std::string_view params[] = {
-		"InputB",
-		"image2",
-		"tex_b",
-	};
-	for (auto& name : params) {
-		if (gs::effect_parameter el = _shader.get_parameter(name.data()); el != nullptr) {
-			if (el.get_type() == gs::effect_parameter::type::Texture) {
-				el.set_texture(tex);
-				break;
-			}
-		}
+	if (_shader_known.input_b) {
+		_shader_known.input_b.set_texture(tex);
 	}
 }
 
@@ -588,10 +780,8 @@ void gfx::shader::shader::set_transition_time(float_t t)
 	if (!_shader)
 		return;
 
-	if (gs::effect_parameter el = _shader.get_parameter("TransitionTime"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Float) {
-			el.set_float(t);
-		}
+	if (_shader_known.transition_time) {
+		_shader_known.transition_time.set_float(t);
 	}
 }
 
@@ -599,10 +789,8 @@ void gfx::shader::shader::set_transition_size(uint32_t w, uint32_t h)
 {
 	if (!_shader)
 		return;
-	if (gs::effect_parameter el = _shader.get_parameter("TransitionSize"); el != nullptr) {
-		if (el.get_type() == gs::effect_parameter::type::Integer2) {
-			el.set_int2(static_cast<int32_t>(w), static_cast<int32_t>(h));
-		}
+	if (_shader_known.transition_size) {
+		_shader_known.transition_size.set_int2(static_cast<int32_t>(w), static_cast<int32_t>(h));
 	}
 }
 
@@ -21,9 +21,11 @@
 #include <list>
 #include <map>
 #include <random>
+#include <vector>
 #include "gfx/shader/gfx-shader-param.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
+#include "util/util-file-watcher.hpp"
 
 namespace gfx {
 	namespace shader {
@@ -40,6 +42,25 @@ namespace gfx {
 
 		typedef std::map<std::string_view, std::shared_ptr<parameter>> shader_param_map_t;
 
+		// Intermediate buffer, rendered by its own technique before the selected one.
+		struct shader_buffer {
+			std::string          technique;
+			gs::effect_parameter param;
+			float_t              scale;
+			gs_color_format      format;
+
+			// Samples its own previous frame, and needs a second target to do so.
+			bool feedback;
+			// Depends on something that changes every frame, instead of only on settings.
+			bool dynamic;
+
+			bool                              valid;
+			uint32_t                          width;
+			uint32_t                          height;
+			std::size_t                       current;
+			std::shared_ptr<gs::rendertarget> rt[2];
+		};
+
 		class shader {
 			obs_source_t* _self;
 
@@ -50,13 +71,27 @@ namespace gfx {
 			bool        _active;
 
 			// Shader
-			gs::effect                      _shader;
-			std::filesystem::path           _shader_file;
-			std::string                     _shader_tech;
-			std::filesystem::file_time_type _shader_file_mt;
-			uintmax_t                       _shader_file_sz;
-			float_t                         _shader_file_tick;
-			shader_param_map_t              _shader_params;
+			gs::effect                                  _shader;
+			std::filesystem::path                       _shader_file;
+			std::string                                 _shader_tech;
+			std::filesystem::file_time_type             _shader_file_mt;
+			uintmax_t                                   _shader_file_sz;
+			std::shared_ptr<util::file_watcher::handle> _shader_file_watch;
+			shader_param_map_t                          _shader_params;
+			std::vector<shader_buffer>                  _shader_buffers;
+			bool                                        _shader_buffers_dirty;
+
+			// Well-known Parameters, resolved once per load.
+			struct {
+				gs::effect_parameter time;
+				gs::effect_parameter view_size;
+				gs::effect_parameter random;
+				gs::effect_parameter random_seed;
+				gs::effect_parameter input_a;
+				gs::effect_parameter input_b;
+				gs::effect_parameter transition_time;
+				gs::effect_parameter transition_size;
+			} _shader_known;
 
 			// Options
 			size_type _width_type;
@@ -75,6 +110,7 @@ namespace gfx {
 
 			// Rendering
 			bool                              _rt_up_to_date;
+			bool                              _rt_dynamic;
 			std::shared_ptr<gs::rendertarget> _rt;
 
 			public:
@@ -114,6 +150,9 @@ namespace gfx {
 
 			void render();
 
+			private:
+			void render_buffers();
+
 			public:
 			void set_size(uint32_t w, uint32_t h);
 
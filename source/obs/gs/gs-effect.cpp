@@ -19,7 +19,10 @@
 
 #include "gs-effect.hpp"
 #include <fstream>
+#include <mutex>
 #include <stdexcept>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 #include "obs/gs/gs-helper.hpp"
 
@@ -43,6 +46,28 @@ static std::string load_file_as_code(std::filesystem::path file)
 	return std::string(buf.data(), buf.data() + size);
 }
 
+namespace {
+	// The deleter also carries the name to parameter table, so that every copy of an effect can find it.
+	struct effect_deleter {
+		std::unordered_map<std::string_view, gs_eparam_t*> parameters;
+
+		void operator()(gs_effect_t* ptr)
+		{
+			auto gctx = gs::context();
+			gs_effect_destroy(ptr);
+		}
+	};
+} // namespace
+
+static std::string defines_as_code(const gs::effect::defines_t& defines)
+{
+	std::string code;
+	for (auto& kv : defines) {
+		code += "#define " + kv.first + " " + kv.second + "\n";
+	}
+	return code;
+}
+
 gs::effect::effect(const std::string& code, const std::string& name)
 {
 	auto gctx = gs::context();
@@ -55,17 +80,96 @@ gs::effect::effect(const std::string& code, const std::string& name)
 						   : std::runtime_error("Unknown error during effect compile.");
 	}
 
-	reset(effect, [](gs_effect_t* ptr) { gs_effect_destroy(ptr); });
+	// Build the parameter table once, instead of comparing names on every lookup.
+	effect_deleter deleter;
+	deleter.parameters.reserve(effect->params.num);
+	for (std::size_t idx = 0; idx < effect->params.num; idx++) {
+		auto ptr = effect->params.array + idx;
+		deleter.parameters.emplace(ptr->name, ptr);
+	}
+
+	reset(effect, std::move(deleter));
 }
 
 gs::effect::effect(std::filesystem::path file) : effect(load_file_as_code(file), file.string()) {}
 
+gs::effect::effect(std::filesystem::path file, const defines_t& defines)
+	: effect(defines_as_code(defines) + load_file_as_code(file), file.string())
+{}
+
 gs::effect::~effect()
 {
 	auto gctx = gs::context();
 	reset();
 }
 
+gs::effect gs::effect::create(std::filesystem::path file, const defines_t& defines)
+{
+	typedef std::tuple<std::string, int64_t, std::string> key_t;
+
+	static std::mutex                                  cache_lock;
+	static std::map<key_t, std::weak_ptr<gs_effect_t>> cache;
+
+	// A changed file gets a new key, so edits are picked up while older users keep their effect.
+	file      = std::filesystem::absolute(file);
+	auto time = std::filesystem::last_write_time(file).time_since_epoch().count();
+	auto key  = key_t{file.string(), static_cast<int64_t>(time), defines_as_code(defines)};
+
+	gs::effect result;
+	{
+		std::unique_lock<std::mutex> ul(cache_lock);
+		if (auto found = cache.find(key); found != cache.end()) {
+			static_cast<std::shared_ptr<gs_effect_t>&>(result) = found->second.lock();
+			if (result) {
+				return result;
+			}
+		}
+	}
+
+	// Compile without holding the lock, as compiling needs the graphics context.
+	result = gs::effect(file, defines);
+
+	{
+		std::unique_lock<std::mutex> ul(cache_lock);
+		for (auto iter = cache.begin(); iter != cache.end();) {
+			if (iter->second.expired()) {
+				iter = cache.erase(iter);
+			} else {
+				iter++;
+			}
+		}
+		cache.emplace(key, result);
+	}
+	return result;
+}
+
+gs::effect_permutations::effect_permutations(std::filesystem::path file) : _file(file), _lock(), _variants() {}
+
+gs::effect_permutations::~effect_permutations()
+{
+	auto gctx = gs::context();
+	_variants.clear();
+}
+
+gs::effect gs::effect_permutations::get(const effect::defines_t& defines)
+{
+	auto key = defines_as_code(defines);
+
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+		if (auto found = _variants.find(key); found != _variants.end()) {
+			return found->second;
+		}
+	}
+
+	// Compile without holding the lock, as compiling needs the graphics context.
+	auto variant = gs::effect::create(_file, defines);
+
+	std::unique_lock<std::mutex> ul(_lock);
+	_variants.emplace(key, variant);
+	return variant;
+}
+
 std::size_t gs::effect::count_techniques()
 {
 	return static_cast<size_t>(get()->techniques.num);
@@ -115,6 +219,13 @@ gs::effect_parameter gs::effect::get_parameter(std::size_t idx)
 
 gs::effect_parameter gs::effect::get_parameter(const std::string& name)
 {
+	if (auto deleter = std::get_deleter<effect_deleter>(*this); deleter) {
+		if (auto found = deleter->parameters.find(name); found != deleter->parameters.end()) {
+			return gs::effect_parameter(found->second, *this);
+		}
+		return nullptr;
+	}
+
 	for (std::size_t idx = 0; idx < count_parameters(); idx++) {
 		auto ptr = get()->params.array + idx;
 		if (strcmp(ptr->name, name.c_str()) == 0) {
@@ -21,15 +21,21 @@
 #include "common.hpp"
 #include <filesystem>
 #include <list>
+#include <map>
+#include <mutex>
 #include "gs-effect-parameter.hpp"
 #include "gs-effect-technique.hpp"
 
 namespace gs {
 	class effect : public std::shared_ptr<gs_effect_t> {
+		public:
+		typedef std::map<std::string, std::string> defines_t;
+
 		public:
 		effect(){};
 		effect(const std::string& code, const std::string& name);
 		effect(std::filesystem::path file);
+		effect(std::filesystem::path file, const defines_t& defines);
 		~effect();
 
 		std::size_t          count_techniques();
@@ -51,12 +57,37 @@ namespace gs {
 
 		static gs::effect create(const std::string& file)
 		{
-			return gs::effect(file);
+			return gs::effect::create(std::filesystem::path(file), defines_t());
 		};
 
+		/** Create an effect from a file, or share an already compiled one.
+		 *
+		 * Effects are cached by file path, modification time and defines, so every user of the same effect file shares
+		 *  a single compiled effect. Users must set all parameters they rely on right before drawing, and must not
+		 *  render anything else in between. Anything else needs a private effect from the constructor.
+		 */
+		static gs::effect create(std::filesystem::path file, const defines_t& defines);
+
 		static gs::effect create(const std::string& code, const std::string& name)
 		{
 			return gs::effect(code, name);
 		};
 	};
+
+	/** Specialised variants of one effect file, selected by preprocessor defines.
+	 *
+	 * Static settings, like modes, can be compiled into an effect instead of being branched on for every pixel.
+	 *  Variants stay compiled for the lifetime of this object, so returning to an earlier combination is free.
+	 */
+	class effect_permutations {
+		std::filesystem::path             _file;
+		std::mutex                        _lock;
+		std::map<std::string, gs::effect> _variants;
+
+		public:
+		effect_permutations(std::filesystem::path file);
+		~effect_permutations();
+
+		gs::effect get(const effect::defines_t& defines);
+	};
 } // namespace gs
@@ -19,25 +19,38 @@
 
 #pragma once
 #include "common.hpp"
-#include <vector>
+#include <chrono>
+#include <cstdarg>
 #include "plugin.hpp"
+#include "util/util-tracing.hpp"
 
 namespace gs {
 	class context {
+		std::chrono::steady_clock::time_point _begin;
+
 		public:
-		inline context()
+		inline context() : _begin()
 		{
-			obs_enter_graphics();
+			// Nested enters only bump a counter, so only the outermost one is worth recording.
+			if (util::tracing::enabled() && (gs_get_context() == nullptr)) {
+				auto wait = std::chrono::steady_clock::now();
+				obs_enter_graphics();
+				_begin = std::chrono::steady_clock::now();
+				util::tracing::record("graphics", "Wait for Graphics Context", wait, _begin);
+			} else {
+				obs_enter_graphics();
+			}
 			if (gs_get_context() == nullptr)
 				throw std::runtime_error("Failed to enter graphics context.");
 		}
 		~context()
 		{
 			obs_leave_graphics();
+			if (_begin.time_since_epoch().count() != 0)
+				util::tracing::record("graphics", "Graphics Context", _begin, std::chrono::steady_clock::now());
 		}
 	};
 
-#ifdef ENABLE_PROFILING
 	static constexpr float_t debug_color_white[4]           = {1.f, 1.f, 1.f, 1.f};
 	static constexpr float_t debug_color_gray[4]            = {.5f, .5f, .5f, 1.f};
 	static constexpr float_t debug_color_black[4]           = {0.f, 0.f, 0.f, 1.f};
@@ -63,28 +76,44 @@ namespace gs {
 	static const float_t* debug_color_allocate     = debug_color_red;
 	static const float_t* debug_color_render       = debug_color_teal;
 
+	/** Marks a section of rendering for graphics debuggers and the tracer.
+	 *
+	 * Graphics debuggers only see markers in builds with profiling enabled, while the tracer sees them whenever
+	 * tracing is enabled. If neither is the case, the marker does not even format its name.
+	 */
 	class debug_marker {
-		std::string _name;
+		char                                  _name[64];
+		std::chrono::steady_clock::time_point _begin;
 
 		public:
-		inline debug_marker(const float_t color[4], const char* format, ...)
+		inline debug_marker(const float_t color[4], const char* format, ...) : _begin()
 		{
-			std::size_t       size;
-			std::vector<char> buffer(64);
+			bool tracing = util::tracing::enabled();
+#ifndef ENABLE_PROFILING
+			(void)color;
+			if (!tracing)
+				return;
+#endif
 
 			va_list vargs;
 			va_start(vargs, format);
-			size = static_cast<size_t>(vsnprintf(buffer.data(), buffer.size(), format, vargs));
+			vsnprintf(_name, sizeof(_name), format, vargs);
 			va_end(vargs);
 
-			_name = std::string(buffer.data(), buffer.data() + size);
-			gs_debug_marker_begin(color, _name.c_str());
+#ifdef ENABLE_PROFILING
+			gs_debug_marker_begin(color, _name);
+#endif
+			if (tracing)
+				_begin = std::chrono::steady_clock::now();
 		}
 
 		inline ~debug_marker()
 		{
+#ifdef ENABLE_PROFILING
 			gs_debug_marker_end();
+#endif
+			if (_begin.time_since_epoch().count() != 0)
+				util::tracing::record("graphics", _name, _begin, std::chrono::steady_clock::now());
 		}
 	};
-#endif
 } // namespace gs
@@ -18,9 +18,11 @@
  */
 
 #include "gs-mipmapper.hpp"
+#include <mutex>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
+#include "util/util-library.hpp"
 
 #ifdef _WIN32
 #ifdef _MSC_VER
@@ -36,14 +38,136 @@
 #endif
 #endif
 
+// OpenGL: libOBS does not expose its function loader, so we resolve the few functions we need ourselves. The values
+// below are taken from the OpenGL 3.3 Core specification.
+#ifdef _WIN32
+#define ST_GLAPI __stdcall
+#else
+#define ST_GLAPI
+#endif
+
+#define ST_GL_TEXTURE_2D 0x0DE1
+#define ST_GL_ACTIVE_TEXTURE 0x84E0
+#define ST_GL_TEXTURE_BINDING_2D 0x8069
+#define ST_GL_TEXTURE_BASE_LEVEL 0x813C
+#define ST_GL_TEXTURE_MAX_LEVEL 0x813D
+#define ST_GL_READ_FRAMEBUFFER 0x8CA8
+#define ST_GL_DRAW_FRAMEBUFFER 0x8CA9
+#define ST_GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define ST_GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define ST_GL_COLOR_ATTACHMENT0 0x8CE0
+#define ST_GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define ST_GL_COLOR_BUFFER_BIT 0x00004000
+#define ST_GL_NEAREST 0x2600
+
+namespace gs::opengl {
+	typedef void(ST_GLAPI* glGetIntegerv_t)(uint32_t pname, int32_t* data);
+	typedef void(ST_GLAPI* glActiveTexture_t)(uint32_t texture);
+	typedef void(ST_GLAPI* glBindTexture_t)(uint32_t target, uint32_t texture);
+	typedef void(ST_GLAPI* glTexParameteri_t)(uint32_t target, uint32_t pname, int32_t param);
+	typedef void(ST_GLAPI* glGetTexParameteriv_t)(uint32_t target, uint32_t pname, int32_t* params);
+	typedef void(ST_GLAPI* glViewport_t)(int32_t x, int32_t y, int32_t width, int32_t height);
+	typedef void(ST_GLAPI* glGenFramebuffers_t)(int32_t n, uint32_t* framebuffers);
+	typedef void(ST_GLAPI* glDeleteFramebuffers_t)(int32_t n, const uint32_t* framebuffers);
+	typedef void(ST_GLAPI* glBindFramebuffer_t)(uint32_t target, uint32_t framebuffer);
+	typedef void(ST_GLAPI* glFramebufferTexture2D_t)(uint32_t target, uint32_t attachment, uint32_t textarget,
+													 uint32_t texture, int32_t level);
+	typedef uint32_t(ST_GLAPI* glCheckFramebufferStatus_t)(uint32_t target);
+	typedef void(ST_GLAPI* glBlitFramebuffer_t)(int32_t srcX0, int32_t srcY0, int32_t srcX1, int32_t srcY1,
+												int32_t dstX0, int32_t dstY0, int32_t dstX1, int32_t dstY1,
+												uint32_t mask, uint32_t filter);
+
+	struct functions {
+		std::shared_ptr<util::library> library;
+
+		glGetIntegerv_t            GetIntegerv;
+		glActiveTexture_t          ActiveTexture;
+		glBindTexture_t            BindTexture;
+		glTexParameteri_t          TexParameteri;
+		glGetTexParameteriv_t      GetTexParameteriv;
+		glViewport_t               Viewport;
+		glGenFramebuffers_t        GenFramebuffers;
+		glDeleteFramebuffers_t     DeleteFramebuffers;
+		glBindFramebuffer_t        BindFramebuffer;
+		glFramebufferTexture2D_t   FramebufferTexture2D;
+		glCheckFramebufferStatus_t CheckFramebufferStatus;
+		glBlitFramebuffer_t        BlitFramebuffer;
+	};
+
+	static std::shared_ptr<functions> get()
+	{
+		static std::shared_ptr<functions> instance;
+		static std::string                error;
+		static std::mutex                 lock;
+
+		std::unique_lock<std::mutex> ul(lock);
+		if (instance) {
+			return instance;
+		} else if (!error.empty()) { // Loading is only attempted once, and only reported once.
+			throw std::runtime_error(error);
+		}
+
+		auto gl = std::make_shared<functions>();
+		try {
+#if defined(_WIN32)
+			gl->library = util::library::load(std::string("opengl32.dll"));
+			auto get_proc_address =
+				reinterpret_cast<void*(ST_GLAPI*)(const char*)>(gl->library->load_symbol("wglGetProcAddress"));
+#elif defined(__APPLE__)
+			gl->library = util::library::load(std::string("/System/Library/Frameworks/OpenGL.framework/OpenGL"));
+			void* (*get_proc_address)(const char*) = nullptr; // The framework exports every function it supports.
+#else
+			gl->library = util::library::load(std::string("libGL.so.1"));
+			auto get_proc_address =
+				reinterpret_cast<void* (*)(const char*)>(gl->library->load_symbol("glXGetProcAddressARB"));
+#endif
+
+			auto load = [&gl, &get_proc_address](auto& fn, const char* name) {
+				void* ptr = gl->library->load_symbol(name);
+				if (!ptr && get_proc_address) {
+					ptr = get_proc_address(name);
+				}
+				if (!ptr) {
+					throw std::runtime_error(std::string("Failed to load OpenGL function: ") + name);
+				}
+				fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(ptr);
+			};
+			load(gl->GetIntegerv, "glGetIntegerv");
+			load(gl->ActiveTexture, "glActiveTexture");
+			load(gl->BindTexture, "glBindTexture");
+			load(gl->TexParameteri, "glTexParameteri");
+			load(gl->GetTexParameteriv, "glGetTexParameteriv");
+			load(gl->Viewport, "glViewport");
+			load(gl->GenFramebuffers, "glGenFramebuffers");
+			load(gl->DeleteFramebuffers, "glDeleteFramebuffers");
+			load(gl->BindFramebuffer, "glBindFramebuffer");
+			load(gl->FramebufferTexture2D, "glFramebufferTexture2D");
+			load(gl->CheckFramebufferStatus, "glCheckFramebufferStatus");
+			load(gl->BlitFramebuffer, "glBlitFramebuffer");
+		} catch (const std::exception& ex) {
+			error = ex.what();
+			DLOG_WARNING("<gs::mipmapper> %s, mipmaps will not be generated.", error.c_str());
+			throw;
+		}
+
+		instance = gl;
+		return gl;
+	}
+} // namespace gs::opengl
+
 gs::mipmapper::~mipmapper()
 {
+	if ((_gl_fbo[0] != 0) || (_gl_fbo[1] != 0)) {
+		auto gctx = gs::context();
+		gs::opengl::get()->DeleteFramebuffers(2, _gl_fbo);
+	}
+
 	_vb.reset();
 	_rt.reset();
 	_effect.reset();
 }
 
-gs::mipmapper::mipmapper()
+gs::mipmapper::mipmapper() : _gl_fbo()
 {
 	_vb = std::make_unique<gs::vertex_buffer>(uint32_t(3u), uint8_t(1u));
 
@@ -106,6 +230,11 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 	// Get a unique lock on the graphics context.
 	auto gctx = gs::context();
 
+	if (gs_get_device_type() == GS_DEVICE_OPENGL) {
+		rebuild_opengl(source, target);
+		return;
+	}
+
 	// Do we need to recreate the render target for a different format?
 	if ((!_rt) || (source->get_color_format() != _rt->get_color_format())) {
 		_rt = std::make_unique<gs::rendertarget>(source->get_color_format(), GS_ZS_NONE);
@@ -124,10 +253,6 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 		d3d_device->GetImmediateContext(&d3d_context);
 	}
 #endif
-	if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-		// FixMe! Implement OpenGL
-	}
-
 	// Use different methods for different types of textures.
 	if (source->get_type() == gs::texture::type::Normal) {
 		while (true) {
@@ -136,9 +261,7 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 			size_t   max_mip_level = 1;
 
 			{
-#ifdef ENABLE_PROFILING
-				auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRId64 "", 0);
-#endif
+				auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRId64 "", int64_t(0));
 
 #ifdef _WIN32
 				if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
@@ -152,9 +275,6 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 					d3d_context->CopySubresourceRegion(d3d_target, 0, 0, 0, 0, d3d_source, 0, nullptr);
 				}
 #endif
-				if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-					// FixMe! Implement OpenGL
-				}
 			}
 
 			// Do we even need to do anything here?
@@ -163,9 +283,7 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 
 			// Render each mip map level.
 			for (size_t mip = 1; mip < max_mip_level; mip++) {
-#ifdef ENABLE_PROFILING
-				auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRIuMAX, mip);
-#endif
+				auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRIuMAX, uintmax_t(mip));
 
 				uint32_t cwidth  = std::max<uint32_t>(width >> mip, 1);
 				uint32_t cheight = std::max<uint32_t>(height >> mip, 1);
@@ -217,9 +335,6 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 					d3d_context->CopySubresourceRegion(d3d_target, level, 0, 0, 0, rtt, 0, &box);
 				}
 #endif
-				if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-					// FixMe! Implement OpenGL
-				}
 			}
 
 			break;
@@ -228,3 +343,130 @@ void gs::mipmapper::rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr
 		throw std::runtime_error("Texture type is not supported by mipmapping yet.");
 	}
 }
+
+void gs::mipmapper::rebuild_opengl(std::shared_ptr<gs::texture> source, std::shared_ptr<gs::texture> target)
+{
+	if (source->get_type() != gs::texture::type::Normal) {
+		throw std::runtime_error("Texture type is not supported by mipmapping yet.");
+	}
+
+	auto     gl        = gs::opengl::get();
+	uint32_t gl_source = *reinterpret_cast<uint32_t*>(gs_texture_get_obj(source->get_object()));
+	uint32_t gl_target = *reinterpret_cast<uint32_t*>(gs_texture_get_obj(target->get_object()));
+	uint32_t width     = source->get_width();
+	uint32_t height    = source->get_height();
+
+	if ((_gl_fbo[0] == 0) || (_gl_fbo[1] == 0)) {
+		gl->GenFramebuffers(2, _gl_fbo);
+	}
+
+	// Remember the bindings libOBS believes are active, it caches them and won't rebind otherwise.
+	int32_t prev_read_fbo = 0;
+	int32_t prev_draw_fbo = 0;
+	gl->GetIntegerv(ST_GL_READ_FRAMEBUFFER_BINDING, &prev_read_fbo);
+	gl->GetIntegerv(ST_GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw_fbo);
+
+	// Run something with the target bound. libOBS changes the active unit and its binding with every draw, so both
+	//  are looked up again on every call and restored afterwards.
+	auto with_target = [&gl, gl_target](auto fn) {
+		int32_t prev_unit    = 0;
+		int32_t prev_texture = 0;
+		gl->GetIntegerv(ST_GL_ACTIVE_TEXTURE, &prev_unit);
+		gl->GetIntegerv(ST_GL_TEXTURE_BINDING_2D, &prev_texture);
+		gl->BindTexture(ST_GL_TEXTURE_2D, gl_target);
+		fn();
+		gl->BindTexture(ST_GL_TEXTURE_2D, static_cast<uint32_t>(prev_texture));
+		gl->ActiveTexture(static_cast<uint32_t>(prev_unit));
+	};
+
+	// Retrieve maximum mip map level.
+	int32_t max_mip_level = 0;
+	with_target([&gl, &max_mip_level]() {
+		gl->GetTexParameteriv(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL, &max_mip_level);
+	});
+
+	// Restrict which levels of the target can be sampled, so that writing to a level never forms a feedback loop.
+	auto set_levels = [&gl, &with_target](int32_t base, int32_t max) {
+		with_target([&gl, base, max]() {
+			gl->TexParameteri(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_BASE_LEVEL, base);
+			gl->TexParameteri(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL, max);
+		});
+	};
+
+	{
+		auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRId32, 0);
+
+		// Copy mip level 0 across textures.
+		gl->BindFramebuffer(ST_GL_READ_FRAMEBUFFER, _gl_fbo[0]);
+		gl->FramebufferTexture2D(ST_GL_READ_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D, gl_source, 0);
+		gl->BindFramebuffer(ST_GL_DRAW_FRAMEBUFFER, _gl_fbo[1]);
+		gl->FramebufferTexture2D(ST_GL_DRAW_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D, gl_target, 0);
+		gl->BlitFramebuffer(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height), 0, 0,
+							static_cast<int32_t>(width), static_cast<int32_t>(height), ST_GL_COLOR_BUFFER_BIT,
+							ST_GL_NEAREST);
+		gl->FramebufferTexture2D(ST_GL_READ_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D, 0, 0);
+		gl->BindFramebuffer(ST_GL_READ_FRAMEBUFFER, static_cast<uint32_t>(prev_read_fbo));
+	}
+
+	// Set up rendering state.
+	gs_viewport_push();
+	gs_projection_push();
+	gs_load_vertexbuffer(_vb->update(false));
+	gs_load_indexbuffer(nullptr);
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_blending(false);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_enable_color(true, true, true, true);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+
+	// Render each mip map level straight into the target.
+	for (int32_t mip = 1; mip <= max_mip_level; mip++) {
+		auto cctr = gs::debug_marker(gs::debug_color_azure_radiance, "Mip Level %" PRId32, mip);
+
+		uint32_t cwidth  = std::max<uint32_t>(width >> mip, 1);
+		uint32_t cheight = std::max<uint32_t>(height >> mip, 1);
+		float_t  iwidth  = 1.f / static_cast<float_t>(cwidth);
+		float_t  iheight = 1.f / static_cast<float_t>(cheight);
+
+		set_levels(mip - 1, mip - 1);
+		gl->FramebufferTexture2D(ST_GL_DRAW_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D, gl_target, mip);
+		if (gl->CheckFramebufferStatus(ST_GL_DRAW_FRAMEBUFFER) != ST_GL_FRAMEBUFFER_COMPLETE) {
+			break;
+		}
+
+		// libOBS only flips and offsets for framebuffers it knows about, so compensate for the swap chain.
+		gs_set_viewport(0, 0, static_cast<int>(cwidth), static_cast<int>(cheight));
+		gl->Viewport(0, 0, static_cast<int32_t>(cwidth), static_cast<int32_t>(cheight));
+		if (gs_get_render_target() != nullptr) {
+			gs_ortho(0, 1, 0, 1, 0, 1);
+		} else {
+			gs_ortho(0, 1, 1, 0, 0, 1);
+		}
+
+		try {
+			// The sampled range starts at the previous level, so level 0 refers to it.
+			_effect.get_parameter("image").set_texture(target);
+			_effect.get_parameter("imageTexel").set_float2(iwidth, iheight);
+			_effect.get_parameter("level").set_int(0);
+			while (gs_effect_loop(_effect.get_object(), "Draw")) {
+				gs_draw(gs_draw_mode::GS_TRIS, 0, _vb->size());
+			}
+		} catch (...) {
+		}
+	}
+
+	// Clean up rendering state.
+	gs_load_indexbuffer(nullptr);
+	gs_load_vertexbuffer(nullptr);
+	gs_blend_state_pop();
+	gs_projection_pop();
+	gs_viewport_pop();
+
+	gl->FramebufferTexture2D(ST_GL_DRAW_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D, 0, 0);
+	gl->BindFramebuffer(ST_GL_DRAW_FRAMEBUFFER, static_cast<uint32_t>(prev_draw_fbo));
+	set_levels(0, max_mip_level);
+}
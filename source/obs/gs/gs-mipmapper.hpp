@@ -30,10 +30,13 @@
  *
  * Needless to say, dynamic mip-map generation costs a lot of GPU time, especially
  *  when things need to be synchronized. In the ideal case we would just render 
- *  straight to the mip level, but this is not possible in DirectX 11 and OpenGL.
+ *  straight to the mip level, but this is not possible in DirectX 11 through libOBS.
  * 
  * So instead we render to a render target and copy from there to the actual
  *  resource. Super wasteful, but what else can we actually do?
+ *
+ * On OpenGL we can attach each mip level to our own framebuffer object and render
+ *  straight into it, limiting the sampled levels to the previous one for each pass.
  */
 
 namespace gs {
@@ -42,10 +45,16 @@ namespace gs {
 		std::unique_ptr<gs::rendertarget>  _rt;
 		gs::effect                         _effect;
 
+		// OpenGL
+		uint32_t _gl_fbo[2];
+
 		public:
 		~mipmapper();
 		mipmapper();
 
 		void rebuild(std::shared_ptr<gs::texture> source, std::shared_ptr<gs::texture> target);
+
+		private:
+		void rebuild_opengl(std::shared_ptr<gs::texture> source, std::shared_ptr<gs::texture> target);
 	};
 } // namespace gs
@@ -0,0 +1,152 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-readback.hpp"
+#include <algorithm>
+#include <cstring>
+#include "gs-helper.hpp"
+#include "gs-rendertarget-pool.hpp"
+
+gs::readback::readback(gs_color_format format, std::size_t depth)
+	: _format(format), _latency(std::max<std::size_t>(depth, 2) - 1), _slots(std::max<std::size_t>(depth, 2)),
+	  _head(0), _count(0), _frames()
+{}
+
+gs::readback::~readback()
+{
+	auto gctx = gs::context{};
+	_slots.clear();
+}
+
+bool gs::readback::stage(gs_texture_t* texture, uint32_t width, uint32_t height)
+{
+	if (!texture || (_count >= _slots.size())) {
+		return false;
+	}
+
+	uint32_t texture_width  = gs_texture_get_width(texture);
+	uint32_t texture_height = gs_texture_get_height(texture);
+	width                   = (width != 0) ? width : texture_width;
+	height                  = (height != 0) ? height : texture_height;
+
+	slot& entry = _slots[_head];
+	if (!entry.surface || (entry.width != width) || (entry.height != height)) {
+		gs::debug_marker gdm{gs::debug_color_allocate, "Reallocate Staging Surface"};
+		entry.surface = std::shared_ptr<gs_stagesurf_t>(gs_stagesurface_create(width, height, _format),
+														[](gs_stagesurf_t* v) { gs_stagesurface_destroy(v); });
+		entry.width   = width;
+		entry.height  = height;
+		if (!entry.surface) {
+			return false;
+		}
+	}
+
+	gs::debug_marker gdm{gs::debug_color_copy, "Stage %" PRIu32 "x%" PRIu32, width, height};
+	if ((width == texture_width) && (height == texture_height) && (gs_texture_get_color_format(texture) == _format)) {
+		gs_stage_texture(entry.surface.get(), texture);
+	} else {
+		// Scale and convert through a transient render target, staging requires an exact match.
+		auto rt = gs::rendertarget_pool::get()->acquire(width, height, _format);
+		{
+			auto         op     = rt->render(width, height);
+			gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+			vec4         clr    = {0., 0., 0., 0.};
+
+			gs_blend_state_push();
+			gs_reset_blend_state();
+			gs_enable_blending(false);
+			gs_ortho(0., 1., 0., 1., -1., 1.);
+			gs_clear(GS_CLEAR_COLOR, &clr, 0., 0);
+
+			gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), texture);
+			while (gs_effect_loop(effect, "Draw")) {
+				gs_draw_sprite(nullptr, 0, 1, 1);
+			}
+			gs_blend_state_pop();
+		}
+		gs_stage_texture(entry.surface.get(), rt->get_object());
+	}
+
+	entry.timestamp = obs_get_video_frame_time();
+	_head           = (_head + 1) % _slots.size();
+	_count++;
+	return true;
+}
+
+std::shared_ptr<gs::readback::frame> gs::readback::read()
+{
+	if (_count == 0) {
+		return nullptr;
+	}
+
+	// Mapping a surface before the GPU finished copying into it would block until it has, so wait a few frames.
+	slot& entry = _slots[(_head + _slots.size() - _count) % _slots.size()];
+	if ((obs_get_video_frame_time() - entry.timestamp) < (obs_get_frame_interval_ns() * _latency)) {
+		return nullptr;
+	}
+	_count--;
+
+	// Reuse a frame nobody else holds on to anymore. Only this thread can hand out new references, so a count of one
+	//  can not change behind our back.
+	std::shared_ptr<frame> result;
+	for (auto& item : _frames) {
+		if (item.use_count() == 1) {
+			result = item;
+			break;
+		}
+	}
+	if (!result) {
+		result = std::make_shared<frame>();
+		_frames.push_back(result);
+	}
+
+	gs::debug_marker gdm{gs::debug_color_copy, "Read Back %" PRIu32 "x%" PRIu32, entry.width, entry.height};
+	uint8_t*         data     = nullptr;
+	uint32_t         linesize = 0;
+	if (!gs_stagesurface_map(entry.surface.get(), &data, &linesize)) {
+		return nullptr;
+	}
+
+	result->width     = entry.width;
+	result->height    = entry.height;
+	result->format    = _format;
+	result->pitch     = (static_cast<std::size_t>(entry.width) * gs_get_format_bpp(_format)) / 8;
+	result->timestamp = entry.timestamp;
+	result->data.resize(result->pitch * entry.height);
+	if (result->pitch == linesize) {
+		memcpy(result->data.data(), data, result->data.size());
+	} else {
+		for (std::size_t y = 0; y < entry.height; y++) {
+			memcpy(&result->data[y * result->pitch], data + y * linesize, result->pitch);
+		}
+	}
+	gs_stagesurface_unmap(entry.surface.get());
+
+	return result;
+}
+
+void gs::readback::clear()
+{
+	_count = 0;
+}
+
+std::size_t gs::readback::pending()
+{
+	return _count;
+}
@@ -0,0 +1,82 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <vector>
+
+/* gs::readback copies textures to system memory without stalling the graphics pipeline.
+ *
+ * Each stage() queues a copy into the next surface of a small ring of staging surfaces, and
+ *  read() only maps a surface once enough frames have passed for the GPU to have finished
+ *  the copy. Frames are handed out as shared pointers which can be passed straight to the
+ *  threadpool as task data. Their buffers are reused once every reference is dropped.
+ *
+ * All functions must be called from within the graphics context.
+ */
+
+namespace gs {
+	class readback {
+		public:
+		struct frame {
+			uint32_t             width;
+			uint32_t             height;
+			gs_color_format      format;
+			std::size_t          pitch; // Bytes per row, rows are tightly packed.
+			uint64_t             timestamp;
+			std::vector<uint8_t> data;
+		};
+
+		private:
+		struct slot {
+			std::shared_ptr<gs_stagesurf_t> surface;
+			uint32_t                        width;
+			uint32_t                        height;
+			uint64_t                        timestamp;
+		};
+
+		gs_color_format                     _format;
+		std::size_t                         _latency;
+		std::vector<slot>                   _slots;
+		std::size_t                         _head;
+		std::size_t                         _count;
+		std::vector<std::shared_ptr<frame>> _frames;
+
+		public:
+		// @param format Format of the delivered pixels, textures in other formats are converted while staging.
+		// @param depth Number of staging surfaces, copies are read back after depth - 1 frames.
+		readback(gs_color_format format = GS_RGBA, std::size_t depth = 3);
+		~readback();
+
+		// Queue a copy of a texture, scaled to the given size if it is not zero.
+		//
+		// @return false if every staging surface is still waiting to be read back.
+		bool stage(gs_texture_t* texture, uint32_t width = 0, uint32_t height = 0);
+
+		// Read back the oldest copy, if the GPU has had enough time to finish it.
+		//
+		// @return The frame, or nullptr if none is ready yet.
+		std::shared_ptr<frame> read();
+
+		// Drop every queued copy without reading it back.
+		void clear();
+
+		std::size_t pending();
+	};
+} // namespace gs
@@ -0,0 +1,132 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-rendertarget-pool.hpp"
+#include "plugin.hpp"
+
+// Frames an idle render target must remain unused before it may be resized for another request.
+#define ST_RESIZE_HYSTERESIS 10
+
+// Frames an idle render target must remain unused before it is destroyed.
+#define ST_EXPIRY 300
+
+static std::shared_ptr<gs::rendertarget_pool> rendertarget_pool_instance;
+
+void gs::rendertarget_pool::tick_handler(void* ptr, float_t) noexcept
+try {
+	gs::rendertarget_pool* self = reinterpret_cast<gs::rendertarget_pool*>(ptr);
+
+	// Destroy expired targets outside of the lock, destruction enters the graphics context.
+	std::list<entry> expired;
+	{
+		std::unique_lock<std::mutex> ul(self->_lock);
+		self->_frame++;
+		for (auto iter = self->_free.begin(); iter != self->_free.end();) {
+			if ((self->_frame - iter->last_used) > ST_EXPIRY) {
+				auto next = std::next(iter);
+				expired.splice(expired.end(), self->_free, iter);
+				iter = next;
+			} else {
+				iter++;
+			}
+		}
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void gs::rendertarget_pool::initialize()
+{
+	rendertarget_pool_instance = std::make_shared<gs::rendertarget_pool>();
+}
+
+void gs::rendertarget_pool::finalize()
+{
+	rendertarget_pool_instance.reset();
+}
+
+std::shared_ptr<gs::rendertarget_pool> gs::rendertarget_pool::get()
+{
+	return rendertarget_pool_instance;
+}
+
+gs::rendertarget_pool::rendertarget_pool() : _lock(), _free(), _frame(0)
+{
+	obs_add_tick_callback(&tick_handler, this);
+}
+
+gs::rendertarget_pool::~rendertarget_pool()
+{
+	obs_remove_tick_callback(&tick_handler, this);
+
+	std::unique_lock<std::mutex> ul(_lock);
+	_free.clear();
+}
+
+std::shared_ptr<gs::rendertarget> gs::rendertarget_pool::acquire(uint32_t width, uint32_t height,
+																 gs_color_format format)
+{
+	std::shared_ptr<gs::rendertarget> target;
+
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+
+		// Prefer a target which already has the requested size, then the one idle for the longest time.
+		auto found = _free.end();
+		for (auto iter = _free.begin(); iter != _free.end(); iter++) {
+			if (iter->format != format) {
+				continue;
+			}
+			if ((iter->width == width) && (iter->height == height)) {
+				found = iter;
+				break;
+			}
+			if ((_frame - iter->last_used) < ST_RESIZE_HYSTERESIS) {
+				continue;
+			}
+			if ((found == _free.end()) || (iter->last_used < found->last_used)) {
+				found = iter;
+			}
+		}
+
+		if (found != _free.end()) {
+			target = found->target;
+			_free.erase(found);
+		}
+	}
+
+	if (!target) {
+		target = std::make_shared<gs::rendertarget>(format, GS_ZS_NONE);
+	}
+
+	// Hand out a reference which returns the target to the pool instead of destroying it.
+	std::weak_ptr<gs::rendertarget_pool> pool = shared_from_this();
+	return std::shared_ptr<gs::rendertarget>(target.get(), [pool, target, width, height, format](gs::rendertarget*) {
+		if (auto self = pool.lock(); self) {
+			self->release(target, width, height, format);
+		}
+	});
+}
+
+void gs::rendertarget_pool::release(std::shared_ptr<gs::rendertarget> target, uint32_t width, uint32_t height,
+									gs_color_format format)
+{
+	std::unique_lock<std::mutex> ul(_lock);
+	_free.push_back({target, width, height, format, _frame});
+}
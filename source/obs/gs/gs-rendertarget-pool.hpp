@@ -0,0 +1,70 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <list>
+#include <mutex>
+#include "gs-rendertarget.hpp"
+
+/* gs::rendertarget_pool hands out transient render targets for intermediate passes.
+ *
+ * Targets are shared between all filters and returned to the pool as soon as the last
+ *  reference to them is dropped. Idle targets are repurposed for a different size only
+ *  after they have not been used for a few frames, so that sources alternating between
+ *  sizes do not cause constant reallocation, and are destroyed once they expire.
+ */
+
+namespace gs {
+	class rendertarget_pool : public std::enable_shared_from_this<gs::rendertarget_pool> {
+		struct entry {
+			std::shared_ptr<gs::rendertarget> target;
+			uint32_t                          width;
+			uint32_t                          height;
+			gs_color_format                   format;
+			uint64_t                          last_used;
+		};
+
+		std::mutex       _lock;
+		std::list<entry> _free;
+		uint64_t         _frame;
+
+		static void tick_handler(void* ptr, float_t time) noexcept;
+
+		public: // Singleton
+		static void                                   initialize();
+		static void                                   finalize();
+		static std::shared_ptr<gs::rendertarget_pool> get();
+
+		public:
+		rendertarget_pool();
+		~rendertarget_pool();
+
+		// Acquire a render target for the given size and format.
+		//
+		// The target is returned to the pool once the last reference is released. Callers must
+		//  keep a reference for as long as they use any texture retrieved from it.
+		std::shared_ptr<gs::rendertarget> acquire(uint32_t width, uint32_t height,
+												  gs_color_format format = GS_RGBA);
+
+		private:
+		void release(std::shared_ptr<gs::rendertarget> target, uint32_t width, uint32_t height,
+					 gs_color_format format);
+	};
+} // namespace gs
@@ -29,6 +29,10 @@ namespace obs {
 		std::map<std::string, std::shared_ptr<obs_source_info>> _proxies;
 		std::set<std::string>                                   _proxy_names;
 
+		// Shared by all instances, and registered by source id in finish_setup().
+		static inline std::shared_ptr<util::profiler> _profile_video_tick;
+		static inline std::shared_ptr<util::profiler> _profile_video_render;
+
 		public:
 		source_factory()
 		{
@@ -165,6 +169,9 @@ namespace obs {
 				}
 			}
 
+			_profile_video_tick   = util::profiler::get(std::string(_info.id) + ".video_tick");
+			_profile_video_render = util::profiler::get(std::string(_info.id) + ".video_render");
+
 			obs_register_source(&_info);
 		}
 
@@ -309,6 +316,7 @@ namespace obs {
 
 		static void _video_tick(void* data, float seconds) noexcept
 		try {
+			util::profiler::instance profile{_profile_video_tick};
 			if (data)
 				reinterpret_cast<_instance*>(data)->video_tick(seconds);
 		} catch (const std::exception& ex) {
@@ -319,6 +327,7 @@ namespace obs {
 
 		static void _video_render(void* data, gs_effect_t* effect) noexcept
 		try {
+			util::profiler::instance profile{_profile_video_render};
 			if (data)
 				reinterpret_cast<_instance*>(data)->video_render(effect);
 		} catch (const std::exception& ex) {
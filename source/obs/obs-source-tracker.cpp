@@ -24,6 +24,41 @@
 
 static std::shared_ptr<obs::source_tracker> source_tracker_instance;
 
+static bool is_source_kind(obs::source_tracker::source_kind kind, obs_source_t* source)
+{
+	switch (kind) {
+	case obs::source_tracker::source_kind::Any:
+		return true;
+	case obs::source_tracker::source_kind::Input:
+		return obs_source_get_type(source) == OBS_SOURCE_TYPE_INPUT;
+	case obs::source_tracker::source_kind::VideoInput:
+		return (obs_source_get_type(source) == OBS_SOURCE_TYPE_INPUT)
+			   && (obs_source_get_output_flags(source) & OBS_SOURCE_VIDEO);
+	case obs::source_tracker::source_kind::AudioInput:
+		return (obs_source_get_type(source) == OBS_SOURCE_TYPE_INPUT)
+			   && (obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO);
+	case obs::source_tracker::source_kind::Scene:
+		return obs_source_get_type(source) == OBS_SOURCE_TYPE_SCENE;
+	case obs::source_tracker::source_kind::Transition:
+		return obs_source_get_type(source) == OBS_SOURCE_TYPE_TRANSITION;
+	default:
+		return false;
+	}
+}
+
+// Output flags can change at any time, so kinds that depend on them share the index of their type and are checked
+//  again during enumeration instead.
+static obs::source_tracker::source_kind index_of(obs::source_tracker::source_kind kind)
+{
+	switch (kind) {
+	case obs::source_tracker::source_kind::VideoInput:
+	case obs::source_tracker::source_kind::AudioInput:
+		return obs::source_tracker::source_kind::Input;
+	default:
+		return kind;
+	}
+}
+
 void obs::source_tracker::source_create_handler(void* ptr, calldata_t* data) noexcept
 try {
 	obs::source_tracker* self = reinterpret_cast<obs::source_tracker*>(ptr);
@@ -47,7 +82,7 @@ try {
 
 	{
 		std::unique_lock<std::mutex> ul(self->_lock);
-		self->_sources.insert({std::string(name), {weak, obs::obs_weak_source_deleter}});
+		self->insert(std::string(name), {weak, obs::obs_weak_source_deleter}, target);
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
@@ -71,11 +106,7 @@ try {
 
 	{
 		std::unique_lock<std::mutex> ul(self->_lock);
-		auto                         found = self->_sources.find(std::string(name));
-		if (found == self->_sources.end()) {
-			return;
-		}
-		self->_sources.erase(found);
+		self->erase(std::string(name), target);
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
@@ -99,25 +130,71 @@ try {
 
 	{
 		std::unique_lock<std::mutex> ul(self->_lock);
-		auto                         found = self->_sources.find(std::string(prev_name));
-		if (found == self->_sources.end()) {
+		auto&                        sources = self->_index[static_cast<std::size_t>(source_kind::Any)].sources;
+		if (sources.find(std::string(prev_name)) == sources.end()) {
 			// Untracked source, insert.
 			obs_weak_source_t* weak = obs_source_get_weak_source(target);
 			if (!weak) {
 				return;
 			}
-			self->_sources.insert({new_name, {weak, obs::obs_weak_source_deleter}});
+			self->insert(std::string(new_name), {weak, obs::obs_weak_source_deleter}, target);
 			return;
 		}
 
-		// Insert at new key, remove old pair.
-		self->_sources.insert({new_name, found->second});
-		self->_sources.erase(found);
+		self->rename(std::string(prev_name), std::string(new_name));
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
 }
 
+void obs::source_tracker::insert(const std::string& name, weak_source_t weak, obs_source_t* source)
+{
+	for (std::size_t idx = 0; idx < _index.size(); idx++) {
+		auto kind = static_cast<source_kind>(idx);
+		if ((index_of(kind) != kind) || !is_source_kind(kind, source)) {
+			continue;
+		}
+
+		auto& index = _index[idx];
+		if (index.sources.insert({name, weak}).second) {
+			index.snapshot.reset();
+		}
+	}
+}
+
+void obs::source_tracker::erase(const std::string& name, obs_source_t* source)
+{
+	for (auto& index : _index) {
+		auto found = index.sources.find(name);
+		if (found == index.sources.end()) {
+			continue;
+		}
+
+		// Another source may have taken over the name, only erase the entry if it still refers to this source.
+		if (!obs_weak_source_references_source(found->second.get(), source)) {
+			continue;
+		}
+
+		index.sources.erase(found);
+		index.snapshot.reset();
+	}
+}
+
+void obs::source_tracker::rename(const std::string& prev_name, const std::string& new_name)
+{
+	for (auto& index : _index) {
+		auto found = index.sources.find(prev_name);
+		if (found == index.sources.end()) {
+			continue;
+		}
+
+		// Insert at new key, remove old pair.
+		index.sources.insert({new_name, found->second});
+		index.sources.erase(found);
+		index.snapshot.reset();
+	}
+}
+
 void obs::source_tracker::initialize()
 {
 	source_tracker_instance = std::make_shared<obs::source_tracker>();
@@ -150,22 +227,34 @@ obs::source_tracker::~source_tracker()
 		signal_handler_disconnect(osi, "source_rename", &source_rename_handler, this);
 	}
 
-	this->_sources.clear();
+	for (auto& index : _index) {
+		index.snapshot.reset();
+		index.sources.clear();
+	}
 }
 
 void obs::source_tracker::enumerate(enumerate_cb_t ecb, filter_cb_t fcb)
 {
-	// Need func-local copy, otherwise we risk corruption if a new source is created or destroyed.
-	decltype(_sources) _clone;
+	enumerate(ecb, source_kind::Any, fcb);
+}
+
+void obs::source_tracker::enumerate(enumerate_cb_t ecb, source_kind kind, filter_cb_t fcb)
+{
+	// Snapshots are immutable and shared, so creating or destroying sources while enumerating is safe.
+	std::shared_ptr<const snapshot_t> snapshot;
 	{
 		std::unique_lock<std::mutex> ul(_lock);
-		_clone = _sources;
+		auto&                        index = _index.at(static_cast<std::size_t>(index_of(kind)));
+		if (!index.snapshot) {
+			index.snapshot = std::make_shared<snapshot_t>(index.sources.begin(), index.sources.end());
+		}
+		snapshot = index.snapshot;
 	}
 
-	for (auto kv : _clone) {
+	for (auto& kv : *snapshot) {
 		auto source =
 			std::shared_ptr<obs_source_t>(obs_weak_source_get_source(kv.second.get()), obs::obs_source_deleter);
-		if (!source) {
+		if (!source || ((index_of(kind) != kind) && !is_source_kind(kind, source.get()))) {
 			continue;
 		}
 
@@ -19,19 +19,48 @@
 
 #pragma once
 #include "common.hpp"
+#include <array>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace obs {
 	class source_tracker {
-		std::map<std::string, std::shared_ptr<obs_weak_source_t>> _sources;
-		std::mutex                                                _lock;
+		public:
+		// Kinds of sources that are indexed separately, so that enumerating one of them does not touch the others.
+		enum class source_kind : std::size_t {
+			Any,        // Every tracked source.
+			Input,      // Sources of type OBS_SOURCE_TYPE_INPUT.
+			VideoInput, // Inputs with video output, as of the time of enumeration.
+			AudioInput, // Inputs with audio output, as of the time of enumeration.
+			Scene,      // Scenes and groups.
+			Transition, // Transitions.
+			_COUNT,
+		};
+
+		private:
+		typedef std::shared_ptr<obs_weak_source_t>                 weak_source_t;
+		typedef std::vector<std::pair<std::string, weak_source_t>> snapshot_t;
+
+		struct index_t {
+			std::map<std::string, weak_source_t> sources;
+
+			// Immutable copy of sources, rebuilt on the first enumeration after a change.
+			std::shared_ptr<const snapshot_t> snapshot;
+		};
+
+		std::array<index_t, static_cast<std::size_t>(source_kind::_COUNT)> _index;
+		std::mutex                                                         _lock;
 
 		static void source_create_handler(void* ptr, calldata_t* data) noexcept;
 		static void source_destroy_handler(void* ptr, calldata_t* data) noexcept;
 		static void source_rename_handler(void* ptr, calldata_t* data) noexcept;
 
+		void insert(const std::string& name, weak_source_t weak, obs_source_t* source);
+		void erase(const std::string& name, obs_source_t* source);
+		void rename(const std::string& prev_name, const std::string& new_name);
+
 		public: // Singleton
 		static void                                 initialize();
 		static void                                 finalize();
@@ -62,6 +91,15 @@ namespace obs {
 		// @param filter_cb Filter function to narrow down results.
 		void enumerate(enumerate_cb_t enumerate_cb, filter_cb_t filter_cb = nullptr);
 
+		//! Enumerate tracked sources of a specific kind
+		//
+		// Uses the index for the given kind, which is cheaper than filtering all sources with filter_cb.
+		//
+		// @param enumerate_cb The function called for each tracked source.
+		// @param kind The kind of sources to enumerate.
+		// @param filter_cb Filter function to narrow down results further.
+		void enumerate(enumerate_cb_t enumerate_cb, source_kind kind, filter_cb_t filter_cb = nullptr);
+
 		public:
 		static bool filter_sources(std::string name, obs_source_t* source);
 		static bool filter_audio_sources(std::string name, obs_source_t* source);
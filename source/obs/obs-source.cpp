@@ -34,7 +34,7 @@ try {
 		self->_self = nullptr;
 	}
 
-	if (self->events.destroy) {
+	if (!self->events.destroy) {
 		return;
 	}
 	self->events.destroy(self);
@@ -21,8 +21,13 @@
 #include <fstream>
 #include <stdexcept>
 #include "configuration.hpp"
+#include "gfx/gfx-source-texture.hpp"
+#include "gfx/gfx-texture-loader.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-vertexbuffer.hpp"
 #include "obs/obs-source-tracker.hpp"
+#include "util/util-file-watcher.hpp"
+#include "util/util-tracing.hpp"
 
 #ifdef ENABLE_ENCODER_FFMPEG
 #include "encoders/encoder-ffmpeg.hpp"
@@ -34,6 +39,9 @@
 #ifdef ENABLE_FILTER_COLOR_GRADE
 #include "filters/filter-color-grade.hpp"
 #endif
+#ifdef ENABLE_FILTER_CPU_FACE_TRACKING
+#include "filters/filter-cpu-face-tracking.hpp"
+#endif
 #ifdef ENABLE_FILTER_DISPLACEMENT
 #include "filters/filter-displacement.hpp"
 #endif
@@ -73,8 +81,78 @@
 //static std::shared_ptr<streamfx::updater> _updater;
 #endif
 
+#define ST_CFG_THREADPOOL_WORKERS "threadpool.workers"
+#define ST_CFG_PROFILER_INTERVAL "profiler.interval"
+#define ST_CFG_TRACING "tracing.enabled"
+#define ST_CFG_TRACING_HOTKEY "tracing.hotkey"
+
+#define ST_I18N_TRACING_TOGGLE "Tracing.Toggle"
+
 static std::shared_ptr<util::threadpool>  _threadpool;
 static std::shared_ptr<gs::vertex_buffer> _gs_fstri_vb;
+static double_t                           _profiler_interval = 0.;
+static double_t                           _profiler_elapsed  = 0.;
+static obs_hotkey_id                      _tracing_hotkey    = OBS_INVALID_HOTKEY_ID;
+
+static void threadpool_tick_handler(void*, float_t) noexcept
+try {
+	// Run continuations of finished tasks on the graphics tick.
+	if (_threadpool)
+		_threadpool->tick();
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+static void profiler_tick_handler(void*, float_t seconds) noexcept
+try {
+	// Periodically dump all registered profilers to the log.
+	_profiler_elapsed += seconds;
+	if (_profiler_elapsed >= _profiler_interval) {
+		_profiler_elapsed = 0.;
+		util::profiler::log_all();
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+static void tracing_dump()
+{
+	// Name the file after the current time, so that consecutive dumps don't overwrite each other.
+	char        name[64];
+	std::time_t now = std::time(nullptr);
+	std::strftime(name, sizeof(name), "traces/%Y-%m-%d_%H-%M-%S.json", std::localtime(&now));
+
+	char* path = obs_module_config_path(name);
+	if (!path) {
+		DLOG_ERROR("Failed to write trace, the module has no configuration path.");
+		return;
+	}
+
+	try {
+		util::tracing::dump(path);
+	} catch (const std::exception& ex) {
+		DLOG_ERROR("Failed to write trace to '%s': %s", path, ex.what());
+	} catch (...) {
+		DLOG_ERROR("Failed to write trace to '%s'.", path);
+	}
+	bfree(path);
+}
+
+static void tracing_hotkey_handler(void*, obs_hotkey_id, obs_hotkey_t*, bool pressed) noexcept
+try {
+	if (!pressed)
+		return;
+
+	if (util::tracing::enabled()) {
+		util::tracing::enable(false);
+		tracing_dump();
+	} else {
+		util::tracing::enable(true);
+		DLOG_INFO("Tracing started.");
+	}
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
 
 MODULE_EXPORT bool obs_module_load(void)
 try {
@@ -84,11 +162,48 @@ try {
 	streamfx::configuration::initialize();
 
 	// Initialize global Thread Pool.
-	_threadpool = std::make_shared<util::threadpool>();
+	{
+		std::size_t workers = 0;
+		if (auto config = streamfx::configuration::instance(); config) {
+			auto data = config->get();
+			if (auto count = obs_data_get_int(data.get(), ST_CFG_THREADPOOL_WORKERS); count > 0)
+				workers = static_cast<std::size_t>(count);
+		}
+		_threadpool = std::make_shared<util::threadpool>(workers);
+		obs_add_tick_callback(&threadpool_tick_handler, nullptr);
+	}
+
+	// Initialize Tracing, which can be toggled with a hotkey at any time.
+	{
+		_tracing_hotkey = obs_hotkey_register_frontend("streamfx.tracing", D_TRANSLATE(ST_I18N_TRACING_TOGGLE),
+													   &tracing_hotkey_handler, nullptr);
+		if (auto config = streamfx::configuration::instance(); config) {
+			auto data = config->get();
+			if (obs_data_array_t* keys = obs_data_get_array(data.get(), ST_CFG_TRACING_HOTKEY); keys) {
+				obs_hotkey_load(_tracing_hotkey, keys);
+				obs_data_array_release(keys);
+			}
+			if (obs_data_get_bool(data.get(), ST_CFG_TRACING)) {
+				util::tracing::enable(true);
+				DLOG_INFO("Tracing started.");
+			}
+		}
+	}
+
+	// Initialize periodic Profiler logging, if enabled.
+	if (auto config = streamfx::configuration::instance(); config) {
+		auto data          = config->get();
+		_profiler_interval = obs_data_get_double(data.get(), ST_CFG_PROFILER_INTERVAL);
+		if (_profiler_interval > 0.)
+			obs_add_tick_callback(&profiler_tick_handler, nullptr);
+	}
 
 	// Initialize Source Tracker
 	obs::source_tracker::initialize();
 
+	// Initialize File Watcher
+	util::file_watcher::initialize();
+
 	// GS Stuff
 	{
 		_gs_fstri_vb = std::make_shared<gs::vertex_buffer>(uint32_t(3), uint8_t(1));
@@ -108,6 +223,10 @@ try {
 			vec4_set(vtx.uv[0], 0, 2, 0, 0);
 		}
 		_gs_fstri_vb->update();
+
+		gs::rendertarget_pool::initialize();
+		gfx::source_texture_factory::initialize();
+		gfx::texture_loader::initialize();
 	}
 
 	// Encoders
@@ -126,6 +245,9 @@ try {
 #ifdef ENABLE_FILTER_COLOR_GRADE
 		streamfx::filter::color_grade::color_grade_factory::initialize();
 #endif
+#ifdef ENABLE_FILTER_CPU_FACE_TRACKING
+		streamfx::filter::cpu::face_tracking_factory::initialize();
+#endif
 #ifdef ENABLE_FILTER_DISPLACEMENT
 		streamfx::filter::displacement::displacement_factory::initialize();
 #endif
@@ -209,6 +331,9 @@ try {
 #ifdef ENABLE_FILTER_COLOR_GRADE
 		streamfx::filter::color_grade::color_grade_factory::finalize();
 #endif
+#ifdef ENABLE_FILTER_CPU_FACE_TRACKING
+		streamfx::filter::cpu::face_tracking_factory::finalize();
+#endif
 #ifdef ENABLE_FILTER_DISPLACEMENT
 		streamfx::filter::displacement::displacement_factory::finalize();
 #endif
@@ -238,9 +363,15 @@ try {
 
 	// GS Stuff
 	{
+		gfx::texture_loader::finalize();
+		gfx::source_texture_factory::finalize();
+		gs::rendertarget_pool::finalize();
 		_gs_fstri_vb.reset();
 	}
 
+	// Finalize File Watcher
+	util::file_watcher::finalize();
+
 	// Finalize Source Tracker
 	obs::source_tracker::finalize();
 
@@ -249,7 +380,30 @@ try {
 	//	_updater.reset();
 	//#endif
 
+	// Finalize Tracing
+	if (util::tracing::enabled()) {
+		util::tracing::enable(false);
+		tracing_dump();
+	}
+	if (_tracing_hotkey != OBS_INVALID_HOTKEY_ID) {
+		if (auto config = streamfx::configuration::instance(); config) {
+			auto              data = config->get();
+			obs_data_array_t* keys = obs_hotkey_save(_tracing_hotkey);
+			obs_data_set_array(data.get(), ST_CFG_TRACING_HOTKEY, keys);
+			obs_data_array_release(keys);
+		}
+		obs_hotkey_unregister(_tracing_hotkey);
+		_tracing_hotkey = OBS_INVALID_HOTKEY_ID;
+	}
+
+	// Finalize Profiler logging
+	if (_profiler_interval > 0.) {
+		obs_remove_tick_callback(&profiler_tick_handler, nullptr);
+		util::profiler::log_all();
+	}
+
 	// Finalize Thread Pool
+	obs_remove_tick_callback(&threadpool_tick_handler, nullptr);
 	_threadpool.reset();
 
 	// Finalize Configuration
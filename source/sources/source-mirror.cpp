@@ -19,6 +19,7 @@
 
 #include "source-mirror.hpp"
 #include "strings.hpp"
+#include <algorithm>
 #include <bitset>
 #include <cstring>
 #include <functional>
@@ -26,6 +27,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <vector>
+#include "gfx/gfx-source-texture.hpp"
 #include "obs/gs/gs-helper.hpp"
 #include "obs/obs-source-tracker.hpp"
 #include "obs/obs-tools.hpp"
@@ -45,35 +47,142 @@
 #define ST_SOURCE_AUDIO ST_SOURCE ".Audio"
 #define ST_SOURCE_AUDIO_LAYOUT ST_SOURCE_AUDIO ".Layout"
 #define ST_SOURCE_AUDIO_LAYOUT_(x) ST_SOURCE_AUDIO_LAYOUT "." D_VSTR(x)
+#define ST_SOURCE_CACHE ST_SOURCE ".Cache"
+#define ST_SOURCE_CACHE_LIMIT ST_SOURCE_CACHE ".Limit"
 
 using namespace streamfx::source::mirror;
 
-mirror_audio_data::mirror_audio_data(const audio_data* audio, speaker_layout layout)
+mirror_audio_queue::mirror_audio_queue(obs_source_t* target)
+	: _target(target), _format(), _samples_per_sec(), _bytes_per_frame(), _buffer(), _blocks(), _head(0), _tail(0)
 {
-	// Build a clone of a packet.
 	audio_t*                 oad = obs_get_audio();
 	const audio_output_info* aoi = audio_output_get_info(oad);
-	osa.frames                   = audio->frames;
-	osa.timestamp                = audio->timestamp;
-	osa.speakers                 = layout;
-	osa.format                   = aoi->format;
-	osa.samples_per_sec          = aoi->samples_per_sec;
-	data.resize(MAX_AV_PLANES);
-	for (std::size_t idx = 0; idx < MAX_AV_PLANES; idx++) {
-		if (!audio->data[idx]) {
-			osa.data[idx] = nullptr;
-			continue;
+	_format                      = aoi->format;
+	_samples_per_sec             = aoi->samples_per_sec;
+	_bytes_per_frame             = get_audio_bytes_per_channel(_format);
+	_buffer.resize(CAPACITY * MAX_AV_PLANES * BLOCK_FRAMES * _bytes_per_frame);
+}
+
+bool mirror_audio_queue::push(const audio_data* audio, speaker_layout layout)
+{
+	for (uint32_t offset = 0; offset < audio->frames;) {
+		uint32_t    frames = static_cast<uint32_t>(std::min<std::size_t>(audio->frames - offset, BLOCK_FRAMES));
+		std::size_t head   = _head.load(std::memory_order_relaxed);
+		if ((head - _tail.load(std::memory_order_acquire)) >= CAPACITY) {
+			return false;
 		}
 
-		data[idx].resize(audio->frames * get_audio_bytes_per_channel(osa.format));
-		memcpy(data[idx].data(), audio->data[idx], data[idx].size());
-		osa.data[idx] = data[idx].data();
+		std::size_t       slot  = head % CAPACITY;
+		obs_source_audio& block = _blocks[slot];
+		block.frames            = frames;
+		block.timestamp         = audio->timestamp + (offset * 1000000000ull) / _samples_per_sec;
+		block.speakers          = layout;
+		block.format            = _format;
+		block.samples_per_sec   = _samples_per_sec;
+		for (std::size_t idx = 0; idx < MAX_AV_PLANES; idx++) {
+			if (!audio->data[idx]) {
+				block.data[idx] = nullptr;
+				continue;
+			}
+
+			uint8_t* plane = &_buffer[(slot * MAX_AV_PLANES + idx) * BLOCK_FRAMES * _bytes_per_frame];
+			memcpy(plane, audio->data[idx] + offset * _bytes_per_frame, frames * _bytes_per_frame);
+			block.data[idx] = plane;
+		}
+
+		_head.store(head + 1, std::memory_order_release);
+		offset += frames;
+	}
+	return true;
+}
+
+void mirror_audio_queue::drain()
+{
+	std::size_t head = _head.load(std::memory_order_acquire);
+	for (std::size_t tail = _tail.load(std::memory_order_relaxed); tail != head; tail++) {
+		obs_source_output_audio(_target, &_blocks[tail % CAPACITY]);
+		_tail.store(tail + 1, std::memory_order_release);
+	}
+}
+
+mirror_audio_forwarder::mirror_audio_forwarder()
+	: _worker(), _lock(), _wake(), _signalled(false), _shutdown(false), _queues_lock(), _queues()
+{
+	_worker = std::thread(&mirror_audio_forwarder::work, this);
+}
+
+mirror_audio_forwarder::~mirror_audio_forwarder()
+{
+	{
+		std::unique_lock<std::mutex> ul(_lock);
+		_shutdown = true;
+		_wake.notify_all();
+	}
+	if (_worker.joinable()) {
+		_worker.join();
+	}
+}
+
+void mirror_audio_forwarder::work()
+{
+	std::unique_lock<std::mutex> ul(_lock);
+	while (!_shutdown) {
+		_wake.wait(ul, [this]() { return _shutdown || _signalled.load(std::memory_order_acquire); });
+
+		// Clear the signal before draining, anything pushed from here on signals again.
+		_signalled.exchange(false, std::memory_order_acq_rel);
+		ul.unlock();
+		{
+			std::unique_lock<std::mutex> ql(_queues_lock);
+			for (auto queue : _queues) {
+				queue->drain();
+			}
+		}
+		ul.lock();
 	}
 }
 
+void mirror_audio_forwarder::add(mirror_audio_queue* queue)
+{
+	std::unique_lock<std::mutex> ul(_queues_lock);
+	_queues.push_back(queue);
+}
+
+void mirror_audio_forwarder::remove(mirror_audio_queue* queue)
+{
+	// The worker holds the lock while draining, so the queue is no longer in use once this returns.
+	std::unique_lock<std::mutex> ul(_queues_lock);
+	_queues.erase(std::remove(_queues.begin(), _queues.end(), queue), _queues.end());
+}
+
+void mirror_audio_forwarder::signal()
+{
+	if (_signalled.exchange(true, std::memory_order_acq_rel)) {
+		return;
+	}
+
+	// Only taken once per wake up, and never while the worker is draining.
+	std::unique_lock<std::mutex> ul(_lock);
+	_wake.notify_one();
+}
+
+std::shared_ptr<mirror_audio_forwarder> mirror_audio_forwarder::instance()
+{
+	static std::mutex                            lock;
+	static std::weak_ptr<mirror_audio_forwarder> weak;
+
+	std::unique_lock<std::mutex> ul(lock);
+	auto                         ptr = weak.lock();
+	if (!ptr) {
+		ptr  = std::make_shared<mirror_audio_forwarder>();
+		weak = ptr;
+	}
+	return ptr;
+}
+
 mirror_instance::mirror_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _source(), _source_child(), _signal_rename(), _audio_enabled(false),
-	  _audio_layout(SPEAKERS_UNKNOWN)
+	: obs::source_instance(settings, self), _source(), _source_child(), _signal_rename(), _cache_enabled(false),
+	  _cache_limit(0), _audio_enabled(false), _audio_layout(SPEAKERS_UNKNOWN), _audio_forwarder(), _audio_queue()
 {}
 
 mirror_instance::~mirror_instance()
@@ -109,6 +218,10 @@ void mirror_instance::migrate(obs_data_t* data, uint64_t version)
 
 void mirror_instance::update(obs_data_t* data)
 {
+	// Cache
+	_cache_enabled = obs_data_get_bool(data, ST_SOURCE_CACHE);
+	_cache_limit   = static_cast<uint32_t>(std::max<int64_t>(obs_data_get_int(data, ST_SOURCE_CACHE_LIMIT), 0));
+
 	// Audio
 	_audio_enabled = obs_data_get_bool(data, ST_SOURCE_AUDIO);
 	_audio_layout  = static_cast<speaker_layout>(obs_data_get_int(data, ST_SOURCE_AUDIO_LAYOUT));
@@ -135,14 +248,35 @@ void mirror_instance::video_render(gs_effect_t* effect)
 	if ((obs_source_get_output_flags(_source.get()) & OBS_SOURCE_VIDEO) == 0)
 		return;
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Source Mirror '%s' for '%s'", obs_source_get_name(_self),
 						  obs_source_get_name(_source.get())};
-#endif
 
 	_source_size.first  = obs_source_get_width(_source.get());
 	_source_size.second = obs_source_get_height(_source.get());
 
+	if (_cache_enabled && (_source_size.first > 0) && (_source_size.second > 0)) {
+		// Captures are shared per source, size and frame, so any number of mirrors of the same source only costs a
+		//  single render of it per frame.
+		uint32_t width  = _source_size.first;
+		uint32_t height = _source_size.second;
+		if ((_cache_limit > 0) && (std::max(width, height) > _cache_limit)) {
+			double_t scale = static_cast<double_t>(_cache_limit) / static_cast<double_t>(std::max(width, height));
+			width          = std::max<uint32_t>(static_cast<uint32_t>(width * scale), 1);
+			height         = std::max<uint32_t>(static_cast<uint32_t>(height * scale), 1);
+		}
+
+		auto tex = gfx::source_texture_factory::get()->render(_source.get(), width, height);
+		if (!tex)
+			return;
+
+		gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), tex->get_object());
+		while (gs_effect_loop(default_effect, "Draw")) {
+			gs_draw_sprite(tex->get_object(), 0, _source_size.first, _source_size.second);
+		}
+		return;
+	}
+
 	obs_source_video_render(_source.get());
 }
 
@@ -185,6 +319,10 @@ try {
 
 	// Listen to any audio the source spews out.
 	if (_audio_enabled) {
+		_audio_queue     = std::make_unique<mirror_audio_queue>(_self);
+		_audio_forwarder = mirror_audio_forwarder::instance();
+		_audio_forwarder->add(_audio_queue.get());
+
 		_signal_audio = std::make_shared<obs::audio_signal_handler>(_source);
 		_signal_audio->event.add(std::bind(&mirror_instance::on_audio, this, std::placeholders::_1,
 										   std::placeholders::_2, std::placeholders::_3));
@@ -195,7 +333,13 @@ try {
 
 void mirror_instance::release()
 {
+	// Stop listening to audio before tearing down the queue, no callback is in progress after this.
 	_signal_audio.reset();
+	if (_audio_queue) {
+		_audio_forwarder->remove(_audio_queue.get());
+		_audio_queue.reset();
+	}
+	_audio_forwarder.reset();
 	_signal_rename.reset();
 	_source_child.reset();
 	_source.reset();
@@ -250,22 +394,10 @@ void mirror_instance::on_audio(std::shared_ptr<obs_source_t>, const audio_data*
 		}
 	}
 
-	{
-		std::unique_lock<std::mutex> ul(_audio_queue_lock);
-		_audio_queue.emplace(audio, detected_layout);
-	}
-
-	// Create a clone of the audio data and push it to the thread pool.
-	streamfx::threadpool()->push(std::bind(&mirror_instance::audio_output, this, std::placeholders::_1), nullptr);
-}
-
-void mirror_instance::audio_output(std::shared_ptr<void> data)
-{
-	std::unique_lock<std::mutex> ul(_audio_queue_lock);
-	while (_audio_queue.size() > 0) {
-		obs_source_output_audio(_self, &((_audio_queue.front()).osa));
-		_audio_queue.pop();
-	}
+	// Copy the packet into the ring and wake up the delivery thread. If the ring is full, the delivery thread has
+	//  fallen far behind and the packet is dropped instead of queueing up ever more latency.
+	_audio_queue->push(audio, detected_layout);
+	_audio_forwarder->signal();
 }
 
 mirror_factory::mirror_factory()
@@ -292,6 +424,8 @@ void mirror_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_string(data, ST_SOURCE, "");
 	obs_data_set_default_bool(data, ST_SOURCE_AUDIO, false);
 	obs_data_set_default_int(data, ST_SOURCE_AUDIO_LAYOUT, static_cast<int64_t>(SPEAKERS_UNKNOWN));
+	obs_data_set_default_bool(data, ST_SOURCE_CACHE, false);
+	obs_data_set_default_int(data, ST_SOURCE_CACHE_LIMIT, 0);
 }
 
 static bool modified_properties(obs_properties_t* pr, obs_property_t* p, obs_data_t* data) noexcept
@@ -301,6 +435,11 @@ try {
 		obs_property_set_visible(obs_properties_get(pr, ST_SOURCE_AUDIO_LAYOUT), show);
 		return true;
 	}
+	if (obs_properties_get(pr, ST_SOURCE_CACHE) == p) {
+		bool show = obs_data_get_bool(data, ST_SOURCE_CACHE);
+		obs_property_set_visible(obs_properties_get(pr, ST_SOURCE_CACHE_LIMIT), show);
+		return true;
+	}
 	return false;
 } catch (...) {
 	return false;
@@ -325,7 +464,7 @@ obs_properties_t* mirror_factory::get_properties2(mirror_instance* data)
 				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_sources);
+			obs::source_tracker::source_kind::Input);
 		obs::source_tracker::get()->enumerate(
 			[&p](std::string name, obs_source_t*) {
 				std::stringstream sstr;
@@ -333,7 +472,19 @@ obs_properties_t* mirror_factory::get_properties2(mirror_instance* data)
 				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
 				return false;
 			},
-			obs::source_tracker::filter_scenes);
+			obs::source_tracker::source_kind::Scene);
+	}
+
+	{
+		p = obs_properties_add_bool(pr, ST_SOURCE_CACHE, D_TRANSLATE(ST_SOURCE_CACHE));
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_SOURCE_CACHE)));
+		obs_property_set_modified_callback(p, modified_properties);
+	}
+
+	{
+		p = obs_properties_add_int(pr, ST_SOURCE_CACHE_LIMIT, D_TRANSLATE(ST_SOURCE_CACHE_LIMIT), 0, 16384, 1);
+		obs_property_set_long_description(p, D_TRANSLATE(D_DESC(ST_SOURCE_CACHE_LIMIT)));
+		obs_property_int_set_suffix(p, " px");
 	}
 
 	{
@@ -19,9 +19,11 @@
 
 #pragma once
 #include "common.hpp"
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 #include "gfx/gfx-source-texture.hpp"
@@ -33,11 +35,64 @@
 #include "obs/obs-tools.hpp"
 
 namespace streamfx::source::mirror {
-	struct mirror_audio_data {
-		mirror_audio_data(const audio_data*, speaker_layout);
+	/** Fixed size single-producer single-consumer ring of audio blocks.
+	 *
+	 * All storage is allocated up front, so pushing and draining never touches the heap. Packets larger than a block
+	 * are split across several blocks, and packets that do not fit anymore are dropped.
+	 */
+	class mirror_audio_queue {
+		public:
+		static constexpr std::size_t CAPACITY     = 16;
+		static constexpr std::size_t BLOCK_FRAMES = 1024;
+
+		private:
+		obs_source_t*                          _target;
+		audio_format                           _format;
+		uint32_t                               _samples_per_sec;
+		std::size_t                            _bytes_per_frame;
+		std::vector<uint8_t>                   _buffer;
+		std::array<obs_source_audio, CAPACITY> _blocks;
+		alignas(64) std::atomic<std::size_t>   _head;
+		alignas(64) std::atomic<std::size_t>   _tail;
+
+		public:
+		mirror_audio_queue(obs_source_t* target);
+
+		// Producer: Copy a packet into the ring, returns false if (part of) it had to be dropped.
+		bool push(const audio_data* audio, speaker_layout layout);
+
+		// Consumer: Output all queued blocks to the target source.
+		void drain();
+	};
+
+	/** Single long-lived thread delivering the audio of all mirror sources.
+	 *
+	 * Shared by all instances and only alive while at least one of them forwards audio.
+	 */
+	class mirror_audio_forwarder {
+		std::thread             _worker;
+		std::mutex              _lock;
+		std::condition_variable _wake;
+		std::atomic<bool>       _signalled;
+		bool                    _shutdown;
 
-		obs_source_audio                  osa;
-		std::vector<std::vector<uint8_t>> data;
+		std::mutex                       _queues_lock;
+		std::vector<mirror_audio_queue*> _queues;
+
+		void work();
+
+		public:
+		mirror_audio_forwarder();
+		~mirror_audio_forwarder();
+
+		void add(mirror_audio_queue* queue);
+		void remove(mirror_audio_queue* queue);
+
+		// Wake up the delivery thread, cheap if it is already awake.
+		void signal();
+
+		public: // Singleton
+		static std::shared_ptr<mirror_audio_forwarder> instance();
 	};
 
 	class mirror_instance : public obs::source_instance {
@@ -48,11 +103,15 @@ namespace streamfx::source::mirror {
 		std::shared_ptr<obs::audio_signal_handler>  _signal_audio;
 		std::pair<uint32_t, uint32_t>               _source_size;
 
+		// Cache
+		bool     _cache_enabled;
+		uint32_t _cache_limit;
+
 		// Audio
-		bool                          _audio_enabled;
-		speaker_layout                _audio_layout;
-		std::mutex                    _audio_queue_lock;
-		std::queue<mirror_audio_data> _audio_queue;
+		bool                                    _audio_enabled;
+		speaker_layout                          _audio_layout;
+		std::shared_ptr<mirror_audio_forwarder> _audio_forwarder;
+		std::unique_ptr<mirror_audio_queue>     _audio_queue;
 
 		public:
 		mirror_instance(obs_data_t* settings, obs_source_t* self);
@@ -78,8 +137,6 @@ namespace streamfx::source::mirror {
 
 		void on_rename(std::shared_ptr<obs_source_t>, calldata*);
 		void on_audio(std::shared_ptr<obs_source_t>, const struct audio_data*, bool);
-
-		void audio_output(std::shared_ptr<void> data);
 	};
 
 	class mirror_factory : public obs::source_factory<source::mirror::mirror_factory, source::mirror::mirror_instance> {
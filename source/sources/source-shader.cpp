@@ -79,9 +79,7 @@ void shader_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
-#ifdef ENABLE_PROFILING
 	gs::debug_marker gdmp{gs::debug_color_source, "Shader Source '%s'", obs_source_get_name(_self)};
-#endif
 
 	_fx->prepare_render();
 	_fx->render();
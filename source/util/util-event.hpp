@@ -19,21 +19,47 @@
 
 #pragma once
 #include "common.hpp"
+#include <cstddef>
 #include <functional>
-#include <list>
+#include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace util {
+	/** Multicast event with copy-on-write listener lists.
+	 *
+	 * The list of listeners is an immutable snapshot that is replaced as a whole whenever a listener is added or
+	 * removed. Calling the event only takes a reference to the current snapshot, so it never blocks on, or allocates
+	 * for, concurrent modification. A listener removed while a call is in progress stays alive until that call is done.
+	 */
 	template<typename... _args>
 	class event {
-		std::list<std::function<void(_args...)>> _listeners;
-		std::recursive_mutex                     _lock;
+		public:
+		typedef std::size_t                                 token_t;
+		typedef std::function<void(_args...)>               listener_t;
+		typedef std::vector<std::pair<token_t, listener_t>> list_t;
+
+		private:
+		std::shared_ptr<const list_t> _listeners;
+		token_t                       _next_token;
+		std::recursive_mutex          _lock;
 
 		std::function<void()> _cb_fill;
 		std::function<void()> _cb_clear;
 
+		inline std::shared_ptr<const list_t> snapshot() const
+		{
+			return std::atomic_load_explicit(&_listeners, std::memory_order_acquire);
+		}
+
+		inline void publish(std::shared_ptr<const list_t> list)
+		{
+			std::atomic_store_explicit(&_listeners, std::move(list), std::memory_order_release);
+		}
+
 		public /* constructor */:
-		event() : _listeners(), _lock(), _cb_fill(), _cb_clear() {}
+		event() : _listeners(), _next_token(0), _lock(), _cb_fill(), _cb_clear() {}
 		virtual ~event()
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
@@ -49,7 +75,9 @@ namespace util {
 			std::lock_guard<std::recursive_mutex> lg(_lock);
 			std::lock_guard<std::recursive_mutex> lgo(other._lock);
 
-			_listeners.swap(other._listeners);
+			publish(other.snapshot());
+			other.publish(nullptr);
+			std::swap(_next_token, other._next_token);
 			_cb_fill.swap(other._cb_fill);
 			_cb_clear.swap(other._cb_clear);
 		}
@@ -65,7 +93,10 @@ namespace util {
 			std::lock_guard<std::recursive_mutex> lg(_lock);
 			std::lock_guard<std::recursive_mutex> lgo(other._lock);
 
-			_listeners.swap(other._listeners);
+			auto list = snapshot();
+			publish(other.snapshot());
+			other.publish(std::move(list));
+			std::swap(_next_token, other._next_token);
 			_cb_fill.swap(other._cb_fill);
 			_cb_clear.swap(other._cb_clear);
 
@@ -73,7 +104,9 @@ namespace util {
 		}
 
 		/** Call the event, going through all listeners in the order they were registered in.
-		*/
+		 *
+		 * Listeners added or removed during the call only take effect for the next call.
+		 */
 		template<typename... _largs>
 		inline void operator()(_args... args)
 		{
@@ -82,9 +115,12 @@ namespace util {
 		template<typename... _largs>
 		inline void call(_args... args)
 		{
-			std::lock_guard<std::recursive_mutex> lg(_lock);
-			for (auto& l : _listeners) {
-				l(args...);
+			std::shared_ptr<const list_t> list = snapshot();
+			if (!list)
+				return;
+
+			for (auto& l : *list) {
+				l.second(args...);
 			}
 		}
 
@@ -92,39 +128,61 @@ namespace util {
 
 		/** Add a new listener to the event.
 		 * @param listener A listener bound with std::bind or a std::function.
+		 * @return token_t Token identifying the listener, for use with remove().
 		 */
-		inline void add(std::function<void(_args...)> listener)
+		inline token_t add(listener_t listener)
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			if (_listeners.size() == 0) {
+			auto                                  list = snapshot();
+			if (!list || list->empty()) {
 				if (_cb_fill) {
 					_cb_fill();
 				}
 			}
-			_listeners.push_back(listener);
+
+			auto    next  = list ? std::make_shared<list_t>(*list) : std::make_shared<list_t>();
+			token_t token = ++_next_token;
+			next->emplace_back(token, std::move(listener));
+			publish(std::move(next));
+			return token;
 		}
-		inline event<_args...>& operator+=(std::function<void(_args...)> listener)
+		inline event<_args...>& operator+=(listener_t listener)
 		{
-			this->add(listener);
+			this->add(std::move(listener));
 			return *this;
 		}
 
 		/** Remove an existing listener from the event.
-		 * @param listener A listener bound with std::bind or a std::function.
+		 * @param token The token returned by add() when the listener was registered.
 		 */
-		inline void remove(std::function<void(_args...)> listener)
+		inline void remove(token_t token)
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			_listeners.remove(listener);
-			if (_listeners.size() == 0) {
+			auto                                  list = snapshot();
+			if (!list)
+				return;
+
+			auto next = std::make_shared<list_t>();
+			next->reserve(list->size());
+			for (auto& l : *list) {
+				if (l.first != token)
+					next->push_back(l);
+			}
+			if (next->size() == list->size())
+				return;
+
+			if (next->empty()) {
+				publish(nullptr);
 				if (_cb_clear) {
 					_cb_clear();
 				}
+			} else {
+				publish(std::move(next));
 			}
 		}
-		inline event<_args...>& operator-=(std::function<void(_args...)> listener)
+		inline event<_args...>& operator-=(token_t token)
 		{
-			this->remove(listener);
+			this->remove(token);
 			return *this;
 		}
 
@@ -133,8 +191,8 @@ namespace util {
 		 */
 		inline bool empty()
 		{
-			std::lock_guard<std::recursive_mutex> lg(_lock);
-			return _listeners.empty();
+			auto list = snapshot();
+			return !list || list->empty();
 		}
 		inline operator bool()
 		{
@@ -142,11 +200,16 @@ namespace util {
 		}
 
 		/** Clear the list of listeners for the event.
+		 *
+		 * The silence callback is only invoked if there were any listeners to clear.
 		 */
 		inline void clear()
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			_listeners.clear();
+			if (!snapshot())
+				return;
+
+			publish(nullptr);
 			if (_cb_clear) {
 				_cb_clear();
 			}
@@ -0,0 +1,281 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "util-file-watcher.hpp"
+#include "common.hpp"
+#include <chrono>
+#include <functional>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define LOCAL_PREFIX "<util::file_watcher> "
+
+// Milliseconds to wait for inotify events before checking if the worker should stop.
+#define INOTIFY_TIMEOUT 250
+
+// Interval at which files are checked for changes when inotify is unavailable.
+#define POLL_INTERVAL std::chrono::milliseconds(333)
+
+static std::shared_ptr<util::file_watcher> file_watcher_instance;
+
+util::file_watcher::handle::handle(std::filesystem::path path) : _path(path), _changed(false) {}
+
+bool util::file_watcher::handle::changed()
+{
+	return _changed.exchange(false);
+}
+
+const std::filesystem::path& util::file_watcher::handle::path()
+{
+	return _path;
+}
+
+void util::file_watcher::initialize()
+{
+	file_watcher_instance = std::make_shared<util::file_watcher>();
+}
+
+void util::file_watcher::finalize()
+{
+	file_watcher_instance.reset();
+}
+
+std::shared_ptr<util::file_watcher> util::file_watcher::get()
+{
+	return file_watcher_instance;
+}
+
+util::file_watcher::file_watcher()
+	: _lock(), _files(), _directories(), _inotify(-1), _worker(), _worker_stop(false)
+{
+#ifdef __linux__
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotify < 0) {
+		DLOG_WARNING(LOCAL_PREFIX "Failed to initialize inotify, falling back to polling.");
+	}
+#endif
+
+	_worker = std::thread(std::bind(&util::file_watcher::work, this));
+}
+
+util::file_watcher::~file_watcher()
+{
+	_worker_stop = true;
+	if (_worker.joinable()) {
+		_worker.join();
+	}
+
+#ifdef __linux__
+	if (_inotify >= 0) {
+		close(_inotify);
+	}
+#endif
+}
+
+std::shared_ptr<util::file_watcher::handle> util::file_watcher::watch(std::filesystem::path path)
+{
+	path     = std::filesystem::absolute(path).lexically_normal();
+	auto hnd = std::make_shared<handle>(path);
+
+	std::unique_lock<std::mutex> ul(_lock);
+
+	auto& entry = _files[path];
+	if (entry.handles.empty()) {
+		std::error_code ec;
+		entry.time = std::filesystem::last_write_time(path, ec);
+		entry.size = std::filesystem::file_size(path, ec);
+	}
+	entry.handles.push_back(hnd);
+
+#ifdef __linux__
+	// Editors often replace files instead of writing to them, so watch the directory instead of the file.
+	if (auto dir = path.parent_path(); (_inotify >= 0) && (_directories.find(dir) == _directories.end())) {
+		int32_t wd =
+			inotify_add_watch(_inotify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB);
+		if (wd >= 0) {
+			_directories.emplace(dir, wd);
+		} else {
+			DLOG_WARNING(LOCAL_PREFIX "Failed to watch directory '%s', changes to '%s' will not be noticed.",
+						 dir.string().c_str(), path.string().c_str());
+		}
+	}
+#endif
+
+	return hnd;
+}
+
+void util::file_watcher::notify(const std::filesystem::path& path)
+{
+	std::unique_lock<std::mutex> ul(_lock);
+
+	auto found = _files.find(path);
+	if (found == _files.end()) {
+		return;
+	}
+
+	for (auto& weak : found->second.handles) {
+		if (auto hnd = weak.lock(); hnd) {
+			hnd->_changed = true;
+		}
+	}
+}
+
+void util::file_watcher::sweep()
+{
+	std::unique_lock<std::mutex> ul(_lock);
+
+	// Forget about files nobody is interested in anymore.
+	for (auto iter = _files.begin(); iter != _files.end();) {
+		iter->second.handles.remove_if([](const std::weak_ptr<handle>& weak) { return weak.expired(); });
+		if (iter->second.handles.empty()) {
+			iter = _files.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+
+	// And stop watching directories which no longer contain any watched files.
+	for (auto iter = _directories.begin(); iter != _directories.end();) {
+		bool used = false;
+		for (auto& kv : _files) {
+			if (kv.first.parent_path() == iter->first) {
+				used = true;
+				break;
+			}
+		}
+
+		if (!used) {
+#ifdef __linux__
+			inotify_rm_watch(_inotify, iter->second);
+#endif
+			iter = _directories.erase(iter);
+		} else {
+			iter++;
+		}
+	}
+}
+
+void util::file_watcher::work()
+{
+	if (_inotify >= 0) {
+		work_inotify();
+	} else {
+		work_poll();
+	}
+}
+
+void util::file_watcher::work_inotify()
+{
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (!_worker_stop) {
+		pollfd pfd = {_inotify, POLLIN, 0};
+		if ((poll(&pfd, 1, INOTIFY_TIMEOUT) > 0) && (pfd.revents & POLLIN)) {
+			ssize_t length = 0;
+			while ((length = read(_inotify, buffer, sizeof(buffer))) > 0) {
+				for (char* ptr = buffer; ptr < (buffer + length);) {
+					auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+					ptr += sizeof(struct inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW) { // Events were lost, so assume everything changed.
+						std::list<std::filesystem::path> paths;
+						{
+							std::unique_lock<std::mutex> ul(_lock);
+							for (auto& kv : _files) {
+								paths.push_back(kv.first);
+							}
+						}
+						for (auto& path : paths) {
+							notify(path);
+						}
+						continue;
+					}
+
+					if (event->len == 0) {
+						continue;
+					}
+
+					std::filesystem::path dir;
+					{
+						std::unique_lock<std::mutex> ul(_lock);
+						for (auto& kv : _directories) {
+							if (kv.second == event->wd) {
+								dir = kv.first;
+								break;
+							}
+						}
+					}
+					if (!dir.empty()) {
+						notify(dir / event->name);
+					}
+				}
+			}
+		}
+
+		sweep();
+	}
+#endif
+}
+
+void util::file_watcher::work_poll()
+{
+	while (!_worker_stop) {
+		std::this_thread::sleep_for(POLL_INTERVAL);
+
+		sweep();
+
+		std::list<std::filesystem::path> paths;
+		{
+			std::unique_lock<std::mutex> ul(_lock);
+			for (auto& kv : _files) {
+				paths.push_back(kv.first);
+			}
+		}
+
+		for (auto& path : paths) {
+			std::error_code ec;
+			auto            time = std::filesystem::last_write_time(path, ec);
+			if (ec) {
+				continue;
+			}
+			auto size = std::filesystem::file_size(path, ec);
+			if (ec) {
+				continue;
+			}
+
+			bool changed = false;
+			{
+				std::unique_lock<std::mutex> ul(_lock);
+				if (auto found = _files.find(path); found != _files.end()) {
+					changed = (found->second.time != time) || (found->second.size != size);
+					found->second.time = time;
+					found->second.size = size;
+				}
+			}
+			if (changed) {
+				notify(path);
+			}
+		}
+	}
+}
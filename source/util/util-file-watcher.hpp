@@ -0,0 +1,89 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/* util::file_watcher watches files for changes on a single background thread.
+ *
+ * On Linux the parent directories are watched with inotify, so nothing touches the file system until a file actually
+ *  changes. Elsewhere, or if inotify is unavailable, each watched file is checked for a new write time and size a few
+ *  times per second instead.
+ */
+
+namespace util {
+	class file_watcher {
+		public:
+		class handle {
+			std::filesystem::path _path;
+			std::atomic_bool      _changed;
+
+			public:
+			handle(std::filesystem::path path);
+
+			// Check if the file changed since the last call, and reset the state.
+			bool changed();
+
+			const std::filesystem::path& path();
+
+			friend class util::file_watcher;
+		};
+
+		private:
+		struct file {
+			std::list<std::weak_ptr<handle>> handles;
+			std::filesystem::file_time_type  time;
+			uintmax_t                        size;
+		};
+
+		std::mutex                               _lock;
+		std::map<std::filesystem::path, file>    _files;
+		std::map<std::filesystem::path, int32_t> _directories;
+		int32_t                                  _inotify;
+		std::thread                              _worker;
+		std::atomic_bool                         _worker_stop;
+
+		public: // Singleton
+		static void                                initialize();
+		static void                                finalize();
+		static std::shared_ptr<util::file_watcher> get();
+
+		public:
+		file_watcher();
+		~file_watcher();
+
+		// Start watching a file.
+		//
+		// The file is watched for as long as the returned handle is alive.
+		std::shared_ptr<handle> watch(std::filesystem::path path);
+
+		private:
+		void notify(const std::filesystem::path& path);
+		void sweep();
+		void work();
+		void work_inotify();
+		void work_poll();
+	};
+} // namespace util
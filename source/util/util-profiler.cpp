@@ -18,12 +18,83 @@
  */
 
 #include "util-profiler.hpp"
-#include <iterator>
+#include <map>
+#include <mutex>
+#include "util-tracing.hpp"
 
-util::profiler::profiler() {}
+// Values below 2^SUB_BITS nanoseconds get their own bucket, above that every power of two is split into
+// 2^(SUB_BITS - 1) buckets.
+#define SUB_BITS 5
+#define SUB_COUNT (1ull << (SUB_BITS - 1))
+
+// Anything longer than 2^MAX_BITS nanoseconds (about 18 minutes) ends up in the last bucket.
+#define MAX_BITS 40
+#define BUCKETS ((MAX_BITS - SUB_BITS + 2) * SUB_COUNT)
+
+// Number of shards, threads are spread over them in the order they first record a sample.
+#define SHARDS 4
+
+struct util::profiler::shard {
+	alignas(64) std::array<std::atomic<uint64_t>, BUCKETS> buckets;
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> total;
+
+	shard() : count(0), total(0)
+	{
+		for (auto& bucket : buckets) {
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+};
+
+static std::size_t bucket_index(uint64_t value)
+{
+	if (value < (1ull << SUB_BITS))
+		return static_cast<std::size_t>(value);
+	if (value >= (1ull << MAX_BITS))
+		return BUCKETS - 1;
+
+	uint64_t msb = 0;
+	for (uint64_t tmp = value; tmp > 1; tmp >>= 1) {
+		msb++;
+	}
+	uint64_t shift = msb - SUB_BITS + 1;
+	return static_cast<std::size_t>((shift * SUB_COUNT) + (value >> shift));
+}
+
+static uint64_t bucket_value(std::size_t index)
+{
+	// Returns the middle of the range covered by the bucket.
+	if (index < (1ull << SUB_BITS))
+		return index;
+
+	uint64_t shift = (index / SUB_COUNT) - 1;
+	uint64_t base  = (index - shift * SUB_COUNT) << shift;
+	return base + ((1ull << shift) >> 1);
+}
+
+static std::size_t local_shard()
+{
+	static std::atomic<std::size_t> next_shard{0};
+	static thread_local std::size_t shard = next_shard.fetch_add(1) % SHARDS;
+	return shard;
+}
+
+util::profiler::profiler() : _shards(std::make_unique<shard[]>(SHARDS)), _name() {}
 
 util::profiler::~profiler() {}
 
+std::vector<uint64_t> util::profiler::merge()
+{
+	std::vector<uint64_t> buckets(BUCKETS, 0);
+	for (std::size_t idx = 0; idx < SHARDS; idx++) {
+		for (std::size_t bucket = 0; bucket < BUCKETS; bucket++) {
+			buckets[bucket] += _shards[idx].buckets[bucket].load(std::memory_order_relaxed);
+		}
+	}
+	return buckets;
+}
+
 std::shared_ptr<util::profiler::instance> util::profiler::track()
 {
 	return std::make_shared<util::profiler::instance>(shared_from_this());
@@ -31,129 +102,97 @@ std::shared_ptr<util::profiler::instance> util::profiler::track()
 
 void util::profiler::track(std::chrono::nanoseconds duration)
 {
-	std::unique_lock<std::mutex> ul(_timings_lock);
-	auto                         itr = _timings.find(duration);
-	if (itr == _timings.end()) {
-		_timings.emplace(duration, 1u);
-	} else {
-		itr->second++;
-	}
+	uint64_t value = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+	auto&    local = _shards[local_shard()];
+
+	local.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+	local.count.fetch_add(1, std::memory_order_relaxed);
+	local.total.fetch_add(value, std::memory_order_relaxed);
 }
 
 uint64_t util::profiler::count()
 {
 	uint64_t count = 0;
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
-	}
-
-	for (auto kv : copy_timings) {
-		count += kv.second;
+	for (std::size_t idx = 0; idx < SHARDS; idx++) {
+		count += _shards[idx].count.load(std::memory_order_relaxed);
 	}
-
 	return count;
 }
 
 std::chrono::nanoseconds util::profiler::total_duration()
 {
-	std::chrono::nanoseconds duration{0};
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
-	}
-
-	for (auto kv : copy_timings) {
-		duration += kv.first * kv.second;
+	uint64_t total = 0;
+	for (std::size_t idx = 0; idx < SHARDS; idx++) {
+		total += _shards[idx].total.load(std::memory_order_relaxed);
 	}
-
-	return duration;
+	return std::chrono::nanoseconds(total);
 }
 
 double_t util::profiler::average_duration()
 {
-	std::chrono::nanoseconds duration{0};
-	uint64_t                 count = 0;
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
+	uint64_t calls = count();
+	if (calls == 0) {
+		return 0.;
 	}
-
-	for (auto kv : copy_timings) {
-		duration += kv.first * kv.second;
-		count += kv.second;
-	}
-
-	return double_t(duration.count()) / double_t(count);
-}
-
-template<typename T>
-inline bool is_equal(T a, T b, T c)
-{
-	return (a == b) || ((a >= (b - c)) && (a <= (b + c)));
+	return double_t(total_duration().count()) / double_t(calls);
 }
 
 std::chrono::nanoseconds util::profiler::percentile(double_t percentile, bool by_time)
 {
-	constexpr double_t edge  = 0.00005;
-	uint64_t           calls = count();
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), inserter(copy_timings, copy_timings.end()));
+	std::vector<uint64_t> buckets = merge();
+
+	uint64_t    calls    = 0;
+	std::size_t smallest = BUCKETS;
+	std::size_t largest  = 0;
+	for (std::size_t idx = 0; idx < BUCKETS; idx++) {
+		if (buckets[idx] > 0) {
+			calls += buckets[idx];
+			smallest = std::min(smallest, idx);
+			largest  = idx;
+		}
+	}
+	if (calls == 0) {
+		return std::chrono::nanoseconds(-1);
 	}
+
 	if (by_time) { // Return by time percentile.
-		// Find largest and smallest time.
-		std::chrono::nanoseconds smallest = copy_timings.begin()->first;
-		std::chrono::nanoseconds largest  = copy_timings.rbegin()->first;
-		std::chrono::nanoseconds variance = largest - smallest;
-
-		for (auto kv : copy_timings) {
-			double_t kv_pct = double_t((kv.first - smallest).count()) / double_t(variance.count());
-			if (is_equal<double_t>(kv_pct, percentile, edge) || (kv_pct > percentile)) {
-				return std::chrono::nanoseconds(kv.first);
+		double_t low    = double_t(bucket_value(smallest));
+		double_t high   = double_t(bucket_value(largest));
+		double_t target = low + (high - low) * percentile;
+
+		for (std::size_t idx = smallest; idx <= largest; idx++) {
+			if ((buckets[idx] > 0) && (double_t(bucket_value(idx)) >= target)) {
+				return std::chrono::nanoseconds(bucket_value(idx));
 			}
 		}
 	} else { // Return by call percentile.
-		if (percentile == 0.0) {
-			return copy_timings.begin()->first;
-		}
-
-		uint64_t accu_calls_now = 0;
-		for (auto kv : copy_timings) {
-			uint64_t accu_calls_last = accu_calls_now;
-			accu_calls_now += kv.second;
+		double_t target = double_t(calls) * percentile;
 
-			double_t percentile_last = double_t(accu_calls_last) / double_t(calls);
-			double_t percentile_now  = double_t(accu_calls_now) / double_t(calls);
-
-			if (is_equal<double_t>(percentile, percentile_now, edge)
-				|| ((percentile_last < percentile) && (percentile_now > percentile))) {
-				return std::chrono::nanoseconds(kv.first);
+		uint64_t accu_calls = 0;
+		for (std::size_t idx = smallest; idx <= largest; idx++) {
+			accu_calls += buckets[idx];
+			if ((buckets[idx] > 0) && (double_t(accu_calls) >= target)) {
+				return std::chrono::nanoseconds(bucket_value(idx));
 			}
 		}
 	}
 
-	return std::chrono::nanoseconds(-1);
+	return std::chrono::nanoseconds(bucket_value(largest));
 }
 
 util::profiler::instance::instance(std::shared_ptr<util::profiler> parent)
-	: _parent(parent), _start(std::chrono::high_resolution_clock::now())
+	: _parent(parent), _start(std::chrono::steady_clock::now())
 {}
 
 util::profiler::instance::~instance()
 {
-	auto end = std::chrono::high_resolution_clock::now();
+	auto end = std::chrono::steady_clock::now();
 	auto dur = end - _start;
 	if (_parent) {
 		_parent->track(dur);
+		if (!_parent->_name.empty() && util::tracing::enabled()) {
+			util::tracing::record("profiler", _parent->_name.c_str(), _start, end);
+		}
 	}
 }
 
@@ -166,3 +205,49 @@ void util::profiler::instance::reparent(std::shared_ptr<util::profiler> parent)
 {
 	_parent = parent;
 }
+
+struct profiler_registry {
+	std::mutex                                             lock;
+	std::map<std::string, std::shared_ptr<util::profiler>> profilers;
+};
+
+static profiler_registry& registry()
+{
+	static profiler_registry instance;
+	return instance;
+}
+
+std::shared_ptr<util::profiler> util::profiler::get(const std::string& name)
+{
+	auto&                        reg = registry();
+	std::unique_lock<std::mutex> ul(reg.lock);
+	if (auto found = reg.profilers.find(name); found != reg.profilers.end()) {
+		return found->second;
+	}
+
+	auto profiler   = create();
+	profiler->_name = name;
+	reg.profilers.emplace(name, profiler);
+	return profiler;
+}
+
+void util::profiler::log_all()
+{
+	std::map<std::string, std::shared_ptr<util::profiler>> profilers;
+	{
+		auto&                        reg = registry();
+		std::unique_lock<std::mutex> ul(reg.lock);
+		profilers = reg.profilers;
+	}
+
+	for (auto& kv : profilers) {
+		uint64_t calls = kv.second->count();
+		if (calls == 0)
+			continue;
+
+		DLOG_INFO("<profiler> %s: %" PRIu64 " calls, %.3f us average, %.3f/%.3f/%.3f/%.3f us at 50/95/99/99.9%%",
+				  kv.first.c_str(), calls, kv.second->average_duration() / 1000.,
+				  kv.second->percentile(0.5).count() / 1000., kv.second->percentile(0.95).count() / 1000.,
+				  kv.second->percentile(0.99).count() / 1000., kv.second->percentile(0.999).count() / 1000.);
+	}
+}
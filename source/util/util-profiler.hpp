@@ -19,19 +19,25 @@
 
 #pragma once
 #include "common.hpp"
+#include <atomic>
 #include <chrono>
-#include <map>
-#include <mutex>
 
 namespace util {
+	/** Lock-free latency histogram.
+	 *
+	 * Samples are sorted into logarithmic buckets (exact below 32ns, within ~6% above that) which are sharded per
+	 * thread, so recording a sample is three relaxed atomic increments. Readers merge the shards on demand.
+	 */
 	class profiler : public std::enable_shared_from_this<util::profiler> {
-		std::map<std::chrono::nanoseconds, size_t> _timings;
-		std::mutex                                 _timings_lock;
+		struct shard;
+
+		std::unique_ptr<shard[]> _shards;
+		std::string              _name;
 
 		public:
 		class instance {
-			std::shared_ptr<profiler>                      _parent;
-			std::chrono::high_resolution_clock::time_point _start;
+			std::shared_ptr<profiler>             _parent;
+			std::chrono::steady_clock::time_point _start;
 
 			public:
 			instance(std::shared_ptr<profiler> parent);
@@ -46,6 +52,8 @@ namespace util {
 		private:
 		profiler();
 
+		std::vector<uint64_t> merge();
+
 		public:
 		~profiler();
 
@@ -66,5 +74,16 @@ namespace util {
 		{
 			return std::shared_ptr<util::profiler>{new profiler()};
 		}
+
+		public /* Registry */:
+		/** Find or create the profiler registered under the given name.
+		 *
+		 * Registered profilers live until the plugin is unloaded, so the result can be cached. Their samples also
+		 * show up as spans while tracing is enabled.
+		 */
+		static std::shared_ptr<util::profiler> get(const std::string& name);
+
+		// Log count, average and percentiles of every registered profiler that has samples.
+		static void log_all();
 	};
 } // namespace util
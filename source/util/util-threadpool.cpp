@@ -20,39 +20,268 @@
 #include "util-threadpool.hpp"
 #include "common.hpp"
 #include <cstddef>
+#include "util-tracing.hpp"
 
 #define LOCAL_PREFIX "<util::threadpool> "
 
 // Most Tasks likely wait for IO, so we can use that time for other tasks.
 #define CONCURRENCY_MULTIPLIER 2
 
-util::threadpool::threadpool() : _workers(), _worker_stop(false), _worker_idx(0), _tasks(), _tasks_lock(), _tasks_cv()
+// Initial capacity of each lane in a worker queue, must be a power of two.
+#define QUEUE_CAPACITY 64
+
+// Size of a single pooled task allocation, which also has to hold the shared_ptr control block.
+#define TASK_BLOCK_SIZE (sizeof(util::threadpool::task) + 64)
+
+// Maximum number of task allocations kept around for reuse.
+#define TASK_BLOCK_CACHE 1024
+
+// Which pool and queue the current thread works for, if any.
+static thread_local util::threadpool* local_threadpool = nullptr;
+static thread_local std::size_t       local_queue      = 0;
+
+class util::threadpool::task_pool {
+	std::mutex         _lock;
+	std::vector<void*> _free;
+
+	public:
+	task_pool() : _lock(), _free()
+	{
+		_free.reserve(TASK_BLOCK_CACHE);
+	}
+
+	~task_pool()
+	{
+		for (void* ptr : _free) {
+			::operator delete(ptr);
+		}
+	}
+
+	void* allocate(std::size_t size)
+	{
+		if (size > TASK_BLOCK_SIZE) {
+			return ::operator new(size);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			if (_free.size() > 0) {
+				void* ptr = _free.back();
+				_free.pop_back();
+				return ptr;
+			}
+		}
+
+		return ::operator new(TASK_BLOCK_SIZE);
+	}
+
+	void deallocate(void* ptr, std::size_t size)
+	{
+		if (size <= TASK_BLOCK_SIZE) {
+			std::unique_lock<std::mutex> lock(_lock);
+			if (_free.size() < TASK_BLOCK_CACHE) {
+				_free.push_back(ptr);
+				return;
+			}
+		}
+
+		::operator delete(ptr);
+	}
+};
+
+// Allocator for std::allocate_shared, so that the task and its control block come from the pool. The pool is kept
+// alive by every allocation, as tasks may outlive the thread pool that created them.
+template<typename T>
+class util::threadpool::task_allocator {
+	public:
+	typedef T value_type;
+
+	std::shared_ptr<util::threadpool::task_pool> _pool;
+
+	task_allocator(std::shared_ptr<util::threadpool::task_pool> pool) : _pool(pool) {}
+
+	template<typename U>
+	task_allocator(const task_allocator<U>& other) : _pool(other._pool)
+	{}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(_pool->allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, std::size_t n)
+	{
+		_pool->deallocate(ptr, n * sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const task_allocator<U>& other) const
+	{
+		return _pool == other._pool;
+	}
+
+	template<typename U>
+	bool operator!=(const task_allocator<U>& other) const
+	{
+		return _pool != other._pool;
+	}
+};
+
+// Per-worker queue with one ring buffer per priority. The owning worker takes from the front, while other workers
+// steal from the back, so they rarely fight over the same lock.
+class util::threadpool::worker_queue {
+	class ring {
+		std::vector<std::shared_ptr<util::threadpool::task>> _buffer;
+		std::size_t                                          _head;
+		std::size_t                                          _count;
+
+		public:
+		ring() : _buffer(QUEUE_CAPACITY), _head(0), _count(0) {}
+
+		void push_back(std::shared_ptr<util::threadpool::task> task)
+		{
+			if (_count == _buffer.size()) {
+				// Only grows, so a queue that has seen its peak load never allocates again.
+				std::vector<std::shared_ptr<util::threadpool::task>> buffer(_buffer.size() * 2);
+				for (std::size_t idx = 0; idx < _count; idx++) {
+					buffer[idx] = std::move(_buffer[(_head + idx) & (_buffer.size() - 1)]);
+				}
+				_buffer.swap(buffer);
+				_head = 0;
+			}
+			_buffer[(_head + _count) & (_buffer.size() - 1)] = std::move(task);
+			_count++;
+		}
+
+		std::shared_ptr<util::threadpool::task> pop_front()
+		{
+			if (_count == 0)
+				return nullptr;
+
+			auto task = std::move(_buffer[_head]);
+			_head     = (_head + 1) & (_buffer.size() - 1);
+			_count--;
+			return task;
+		}
+
+		std::shared_ptr<util::threadpool::task> pop_back()
+		{
+			if (_count == 0)
+				return nullptr;
+
+			_count--;
+			return std::move(_buffer[(_head + _count) & (_buffer.size() - 1)]);
+		}
+	};
+
+	std::mutex                                                              _lock;
+	std::array<ring, static_cast<std::size_t>(threadpool_priority::_COUNT)> _lanes;
+
+	public:
+	void push(std::shared_ptr<util::threadpool::task> task, threadpool_priority priority)
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		_lanes[static_cast<std::size_t>(priority)].push_back(std::move(task));
+	}
+
+	std::shared_ptr<util::threadpool::task> take(threadpool_priority priority)
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		return _lanes[static_cast<std::size_t>(priority)].pop_front();
+	}
+
+	std::shared_ptr<util::threadpool::task> steal(threadpool_priority priority)
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		return _lanes[static_cast<std::size_t>(priority)].pop_back();
+	}
+};
+
+util::threadpool::threadpool(std::size_t workers)
+	: _pool(std::make_shared<task_pool>()), _queues(), _workers(), _worker_stop(false), _worker_idx(0), _next_queue(0),
+	  _pending(0), _idle(0), _idle_lock(), _idle_cv()
 {
-	std::size_t concurrency = static_cast<size_t>(std::thread::hardware_concurrency() * CONCURRENCY_MULTIPLIER);
-	for (std::size_t n = 0; n < concurrency; n++) {
-		_workers.emplace_back(std::bind(&util::threadpool::work, this));
+	if (workers == 0) {
+		workers = static_cast<size_t>(std::thread::hardware_concurrency() * CONCURRENCY_MULTIPLIER);
+	}
+	workers = std::max<std::size_t>(workers, 1);
+	for (auto& pending : _pending_priority) {
+		pending.store(0);
+	}
+
+	// All queues must exist before the first worker starts stealing from them.
+	for (std::size_t n = 0; n < workers; n++) {
+		_queues.emplace_back(std::make_unique<worker_queue>());
+	}
+	for (std::size_t n = 0; n < workers; n++) {
+		_workers.emplace_back(std::bind(&util::threadpool::work, this, n));
 	}
 }
 
 util::threadpool::~threadpool()
 {
-	_worker_stop = true;
-	_tasks_cv.notify_all();
+	{
+		std::unique_lock<std::mutex> lock(_idle_lock);
+		_worker_stop = true;
+		_idle_cv.notify_all();
+	}
 	for (auto& thread : _workers) {
-		_tasks_cv.notify_all();
 		if (thread.joinable()) {
 			thread.join();
 		}
 	}
+
+	// Drop anything still queued, so that nobody waits on a group forever.
+	for (auto& queue : _queues) {
+		for (std::size_t lane = 0; lane < static_cast<std::size_t>(threadpool_priority::_COUNT); lane++) {
+			while (auto task = queue->steal(static_cast<threadpool_priority>(lane))) {
+				if (task->_group) {
+					task->_group->complete(task.get());
+				}
+			}
+		}
+	}
+}
+
+std::size_t util::threadpool::size()
+{
+	return _queues.size();
+}
+
+std::shared_ptr<::util::threadpool::task> util::threadpool::push(threadpool_callback_t fn, threadpool_data_t data,
+																  threadpool_priority priority)
+{
+	threadpool_options options;
+	options.priority = priority;
+	return push(std::move(fn), std::move(data), std::move(options));
 }
 
-std::shared_ptr<::util::threadpool::task> util::threadpool::push(threadpool_callback_t fn, threadpool_data_t data)
+std::shared_ptr<::util::threadpool::task> util::threadpool::push(threadpool_callback_t fn, threadpool_data_t data,
+																  threadpool_options options)
 {
-	auto task = std::make_shared<util::threadpool::task>(fn, data);
+	auto task = std::allocate_shared<util::threadpool::task>(task_allocator<util::threadpool::task>(_pool),
+															 std::move(fn), std::move(data), std::move(options));
+	if (task->_group) {
+		task->_group->add(task.get());
+	}
+
+	// Work pushed from inside a worker stays on that worker, everything else is spread out evenly.
+	std::size_t index;
+	if (local_threadpool == this) {
+		index = local_queue;
+	} else {
+		index = _next_queue.fetch_add(1) % _queues.size();
+	}
+	// Count the task before it becomes visible, so that the counters never drop below the number of queued tasks.
+	_pending_priority[static_cast<std::size_t>(task->_priority)].fetch_add(1);
+	_pending.fetch_add(1);
+	_queues[index]->push(task, task->_priority);
 
-	std::unique_lock<std::mutex> lock(_tasks_lock);
-	_tasks.emplace_back(task);
-	_tasks_cv.notify_one();
+	// Only wake a worker if one is actually sleeping, which avoids the lock entirely under load.
+	if (_idle.load() > 0) {
+		std::unique_lock<std::mutex> lock(_idle_lock);
+		_idle_cv.notify_one();
+	}
 
 	return task;
 }
@@ -64,40 +293,79 @@ void util::threadpool::pop(std::shared_ptr<::util::threadpool::task> work)
 	}
 }
 
-void util::threadpool::work()
+void util::threadpool::tick()
 {
-	std::shared_ptr<util::threadpool::task> local_work{};
-	uint32_t                                local_number = _worker_idx.fetch_add(1);
+	{
+		std::unique_lock<std::mutex> lock(_continuations_lock);
+		_continuations_tick.swap(_continuations);
+	}
 
-	while (!_worker_stop) {
-		// Wait for more work, or immediately continue if there is still work to do.
-		{
-			// Lock the tasks mutex to check for work.
-			std::unique_lock<std::mutex> lock(_tasks_lock);
+	for (auto& continuation : _continuations_tick) {
+		try {
+			continuation.first(continuation.second);
+		} catch (std::exception const& ex) {
+			DLOG_WARNING(LOCAL_PREFIX "Continuation (%" PRIxPTR ") failed with message: %s",
+						 reinterpret_cast<ptrdiff_t>(continuation.second.get()), ex.what());
+		} catch (...) {
+			DLOG_WARNING(LOCAL_PREFIX "Continuation (%" PRIxPTR ") failed with exception of unknown type.",
+						 reinterpret_cast<ptrdiff_t>(continuation.second.get()));
+		}
+	}
 
-			// If there are currently no tasks queued, wait on the condition variable.
-			// This temporarily unlocks the mutex until it is woken up.
-			if (_tasks.size() == 0) {
-				_tasks_cv.wait(lock, [this]() { return _worker_stop || _tasks.size() > 0; });
-			}
+	// Keep the capacity around, so that steady state ticks do not allocate.
+	_continuations_tick.clear();
+}
 
-			// If there is either no tasks or we were asked to stop, skip everything.
-			if (_worker_stop || (_tasks.size() == 0)) {
-				continue;
-			}
+std::shared_ptr<::util::threadpool::task> util::threadpool::acquire(std::size_t index)
+{
+	// Higher priorities always win, even if the work for them has to be stolen from another worker. Other queues are
+	//  only visited if the counters say that there is something to find, so an idle lane costs a single atomic load.
+	for (std::size_t lane = 0; lane < PRIORITY_COUNT; lane++) {
+		auto priority = static_cast<threadpool_priority>(lane);
+
+		std::shared_ptr<util::threadpool::task> task = _queues[index]->take(priority);
+		for (std::size_t n = 1; !task && (n < _queues.size()) && (_pending_priority[lane].load() > 0); n++) {
+			task = _queues[(index + n) % _queues.size()]->steal(priority);
+		}
 
-			// Grab the latest task and immediately remove it from the queue.
-			local_work = _tasks.front();
-			_tasks.pop_front();
+		if (task) {
+			_pending_priority[lane].fetch_sub(1);
+			_pending.fetch_sub(1);
+			return task;
 		}
+	}
+
+	return nullptr;
+}
+
+void util::threadpool::work(std::size_t index)
+{
+	std::shared_ptr<util::threadpool::task> local_work{};
+	uint32_t                                local_number = _worker_idx.fetch_add(1);
 
-		// If the task was killed, skip everything again.
-		if (local_work->_is_dead) {
+	local_threadpool = this;
+	local_queue      = index;
+
+	while (!_worker_stop) {
+		// Grab the next task from our own queue, or steal one from another worker.
+		local_work = acquire(index);
+		if (!local_work) {
+			// If there is nothing to do anywhere, sleep until new work is pushed. This temporarily unlocks the mutex
+			// until it is woken up.
+			std::unique_lock<std::mutex> lock(_idle_lock);
+			_idle.fetch_add(1);
+			_idle_cv.wait(lock, [this]() { return _worker_stop || (_pending.load() > 0); });
+			_idle.fetch_sub(1);
 			continue;
 		}
 
+		// Skip tasks that were killed, or are no longer useful as they missed their deadline.
+		bool success = !local_work->_is_dead && (std::chrono::steady_clock::now() <= local_work->_deadline);
+
 		// Try to execute work, but don't crash on catchable exceptions.
-		if (local_work->_callback) {
+		if (success && local_work->_callback) {
+			bool                 realtime = (local_work->_priority == threadpool_priority::Realtime);
+			util::tracing::scope trace{"threadpool", realtime ? "Realtime Task" : "Background Task"};
 			try {
 				local_work->_callback(local_work->_data);
 			} catch (std::exception const& ex) {
@@ -105,22 +373,102 @@ void util::threadpool::work()
 										  ") with message: %s",
 							 local_number, reinterpret_cast<ptrdiff_t>(local_work->_callback.target<void>()),
 							 reinterpret_cast<ptrdiff_t>(local_work->_data.get()), ex.what());
+				success = false;
 			} catch (...) {
 				DLOG_WARNING(LOCAL_PREFIX "Worker %" PRIx32 " caught exception of unknown type from task (%" PRIxPTR
 										  ", %" PRIxPTR ").",
 							 local_number, reinterpret_cast<ptrdiff_t>(local_work->_callback.target<void>()),
 							 reinterpret_cast<ptrdiff_t>(local_work->_data.get()));
+				success = false;
 			}
 		}
 
+		// Hand the continuation over to the next tick.
+		if (success && local_work->_continuation) {
+			std::unique_lock<std::mutex> lock(_continuations_lock);
+			_continuations.emplace_back(std::move(local_work->_continuation), local_work->_data);
+		}
+
+		// Tell the group that we're done, even if the task never ran.
+		if (local_work->_group) {
+			local_work->_group->complete(local_work.get());
+		}
+
 		// Remove our reference to the work unit.
 		local_work.reset();
 	}
 
+	local_threadpool = nullptr;
 	_worker_idx.fetch_sub(1);
 }
 
-util::threadpool::task::task() {}
+util::threadpool::task::task()
+	: _is_dead(false), _priority(threadpool_priority::Background),
+	  _deadline(std::chrono::steady_clock::time_point::max()), _group_prev(nullptr), _group_next(nullptr)
+{}
 
-util::threadpool::task::task(threadpool_callback_t fn, threadpool_data_t dt) : _is_dead(false), _callback(fn), _data(dt)
+util::threadpool::task::task(threadpool_callback_t fn, threadpool_data_t dt, threadpool_options options)
+	: _is_dead(false), _callback(std::move(fn)), _data(std::move(dt)), _priority(options.priority),
+	  _deadline(options.deadline), _group(std::move(options.group)), _continuation(std::move(options.continuation)),
+	  _group_prev(nullptr), _group_next(nullptr)
 {}
+
+// Tasks are linked into the group directly instead of being tracked in a container, so that adding one never
+//  allocates. A linked task is always kept alive by a queue or a worker, which unlink it before letting go.
+util::threadpool_group::threadpool_group() : _lock(), _cv(), _head(nullptr), _count(0) {}
+
+util::threadpool_group::~threadpool_group() {}
+
+std::size_t util::threadpool_group::pending()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	return _count;
+}
+
+void util::threadpool_group::wait()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_cv.wait(lock, [this]() { return _count == 0; });
+}
+
+void util::threadpool_group::cancel()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	for (auto task = _head; task; task = task->_group_next) {
+		task->_is_dead.store(true);
+	}
+}
+
+void util::threadpool_group::add(::util::threadpool::task* task)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	task->_group_prev = nullptr;
+	task->_group_next = _head;
+	if (_head) {
+		_head->_group_prev = task;
+	}
+	_head = task;
+	_count++;
+}
+
+void util::threadpool_group::complete(::util::threadpool::task* task)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	if (task->_group_prev) {
+		task->_group_prev->_group_next = task->_group_next;
+	} else if (_head == task) {
+		_head = task->_group_next;
+	} else {
+		return; // Not linked, already completed.
+	}
+	if (task->_group_next) {
+		task->_group_next->_group_prev = task->_group_prev;
+	}
+	task->_group_prev = nullptr;
+	task->_group_next = nullptr;
+	_count--;
+
+	if (_count == 0) {
+		_cv.notify_all();
+	}
+}
@@ -18,7 +18,9 @@
  */
 
 #pragma once
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <list>
@@ -26,43 +28,143 @@
 #include <mutex>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 namespace util {
 	typedef std::shared_ptr<void>                  threadpool_data_t;
 	typedef std::function<void(threadpool_data_t)> threadpool_callback_t;
 
+	enum class threadpool_priority : uint8_t {
+		// Work that the video or audio thread is waiting on, like tracking or audio delivery.
+		Realtime,
+		// Work that nobody is waiting on right now, like update checks or file decoding.
+		Background,
+
+		_COUNT,
+	};
+
+	class threadpool;
+	class threadpool_group;
+
+	struct threadpool_options {
+		threadpool_priority priority = threadpool_priority::Background;
+
+		// Tasks that have not started by this point are dropped without running.
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+		// Group to track the task in, see threadpool_group.
+		std::shared_ptr<threadpool_group> group = nullptr;
+
+		// Called with the same data on the next threadpool::tick() after the task ran successfully.
+		threadpool_callback_t continuation = nullptr;
+	};
+
 	class threadpool {
 		public:
 		class task {
 			protected:
-			std::atomic_bool      _is_dead;
-			threadpool_callback_t _callback;
-			threadpool_data_t     _data;
+			std::atomic_bool                      _is_dead;
+			threadpool_callback_t                 _callback;
+			threadpool_data_t                     _data;
+			threadpool_priority                   _priority;
+			std::chrono::steady_clock::time_point _deadline;
+			std::shared_ptr<threadpool_group>     _group;
+			threadpool_callback_t                 _continuation;
+
+			// Intrusive links for threadpool_group, only touched while holding the group lock.
+			task* _group_prev;
+			task* _group_next;
 
 			public:
 			task();
-			task(threadpool_callback_t callback_function, threadpool_data_t data);
+			task(threadpool_callback_t callback_function, threadpool_data_t data, threadpool_options options);
 
 			friend class util::threadpool;
+			friend class util::threadpool_group;
 		};
 
 		private:
-		std::list<std::thread>                               _workers;
-		std::atomic_bool                                     _worker_stop;
-		std::atomic<uint32_t>                                _worker_idx;
-		std::list<std::shared_ptr<::util::threadpool::task>> _tasks;
-		std::mutex                                           _tasks_lock;
-		std::condition_variable                              _tasks_cv;
+		class task_pool;
+		template<typename T>
+		class task_allocator;
+		class worker_queue;
+
+		static constexpr std::size_t PRIORITY_COUNT = static_cast<std::size_t>(threadpool_priority::_COUNT);
+
+		std::shared_ptr<task_pool>                 _pool;
+		std::vector<std::unique_ptr<worker_queue>> _queues;
+		std::list<std::thread>                     _workers;
+		std::atomic_bool                           _worker_stop;
+		std::atomic<uint32_t>                      _worker_idx;
+		std::atomic<std::size_t>                   _next_queue;
+		std::atomic<int64_t>                       _pending;
+		std::atomic<int64_t>                       _pending_priority[PRIORITY_COUNT];
+		std::atomic<std::size_t>                   _idle;
+		std::mutex                                 _idle_lock;
+		std::condition_variable                    _idle_cv;
+
+		std::mutex                                                       _continuations_lock;
+		std::vector<std::pair<threadpool_callback_t, threadpool_data_t>> _continuations;
+		std::vector<std::pair<threadpool_callback_t, threadpool_data_t>> _continuations_tick;
 
 		public:
-		threadpool();
+		/** Create a new thread pool.
+		 *
+		 * @param workers Number of worker threads, or 0 to pick a number based on the available hardware threads.
+		 */
+		threadpool(std::size_t workers = 0);
 		~threadpool();
 
-		std::shared_ptr<::util::threadpool::task> push(threadpool_callback_t callback_function, threadpool_data_t data);
+		std::size_t size();
+
+		std::shared_ptr<::util::threadpool::task> push(threadpool_callback_t callback_function, threadpool_data_t data,
+													   threadpool_priority priority = threadpool_priority::Background);
+
+		std::shared_ptr<::util::threadpool::task> push(threadpool_callback_t callback_function, threadpool_data_t data,
+													   threadpool_options options);
 
 		void pop(std::shared_ptr<::util::threadpool::task> work);
 
+		/** Run all continuations of tasks that finished since the last call.
+		 *
+		 * Must be called from a single thread, usually the graphics tick.
+		 */
+		void tick();
+
+		private:
+		std::shared_ptr<::util::threadpool::task> acquire(std::size_t index);
+
+		void work(std::size_t index);
+	};
+
+	/** Tracks a set of tasks so they can be waited on or cancelled together.
+	 *
+	 * Never wait on a group from a task that is itself part of the group.
+	 */
+	class threadpool_group {
+		std::mutex                _lock;
+		std::condition_variable   _cv;
+		::util::threadpool::task* _head;
+		std::size_t               _count;
+
+		public:
+		threadpool_group();
+		~threadpool_group();
+
+		// Number of tasks that are queued or running.
+		std::size_t pending();
+
+		// Block until every task in the group has finished or was dropped.
+		void wait();
+
+		// Drop every task in the group that has not started yet. Running tasks are not interrupted.
+		void cancel();
+
 		private:
-		void work();
+		void add(::util::threadpool::task* task);
+
+		void complete(::util::threadpool::task* task);
+
+		friend class util::threadpool;
 	};
 } // namespace util
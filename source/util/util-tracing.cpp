@@ -0,0 +1,253 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+
+
+#include "util-tracing.hpp"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#define LOCAL_PREFIX "<util::tracing> "
+
+// Number of spans kept per thread, must be a power of two.
+#define RING_SIZE 4096
+
+// Maximum length of a span name, including the terminating zero.
+#define NAME_LENGTH 48
+
+namespace util::tracing {
+	struct event {
+		char        name[NAME_LENGTH];
+		const char* category;
+		uint64_t    thread;
+		int64_t     begin;
+		int64_t     duration;
+	};
+
+	// Events are moved in and out of the ring as relaxed atomic words, so a reader racing the writer sees stale or
+	//  torn data instead of undefined behavior. Torn events are then dropped by checking head again.
+	static_assert(std::is_trivially_copyable_v<event> && (sizeof(event) % sizeof(uint64_t)) == 0);
+	struct slot {
+		std::array<std::atomic<uint64_t>, sizeof(event) / sizeof(uint64_t)> words;
+
+		void store(const event& ev)
+		{
+			std::array<uint64_t, sizeof(event) / sizeof(uint64_t)> buffer;
+			std::memcpy(buffer.data(), &ev, sizeof(event));
+			for (size_t idx = 0; idx < buffer.size(); idx++) {
+				words[idx].store(buffer[idx], std::memory_order_relaxed);
+			}
+		}
+
+		void load(event& ev) const
+		{
+			std::array<uint64_t, sizeof(event) / sizeof(uint64_t)> buffer;
+			for (size_t idx = 0; idx < buffer.size(); idx++) {
+				buffer[idx] = words[idx].load(std::memory_order_relaxed);
+			}
+			std::memcpy(&ev, buffer.data(), sizeof(event));
+		}
+	};
+
+	// Written only by the owning thread. Readers copy the events and then check that the writer did not lap them.
+	struct ring {
+		std::atomic<uint64_t>       head;
+		std::array<slot, RING_SIZE> events;
+
+		ring() : head(0), events() {}
+	};
+
+	// Hands the ring of a thread over to the next new thread once it exits, so that threads which come and go don't
+	//  leave their rings behind. Spans already recorded stay in the ring until they are overwritten.
+	struct owner {
+		std::shared_ptr<ring> local;
+		uint64_t              thread = 0;
+
+		~owner();
+	};
+
+	static std::atomic_bool                   _enabled{false};
+	static std::atomic<int64_t>               _start{0};
+	static std::atomic<uint64_t>              _threads{0};
+	static std::mutex                         _rings_lock;
+	static std::vector<std::shared_ptr<ring>> _rings;
+	static std::vector<std::shared_ptr<ring>> _free;
+
+	static const std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+
+	static int64_t to_ns(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time - _epoch).count();
+	}
+
+	owner::~owner()
+	{
+		if (local) {
+			std::unique_lock<std::mutex> lock(_rings_lock);
+			_free.push_back(std::move(local));
+		}
+	}
+
+	static owner& local_owner()
+	{
+		static thread_local owner local;
+		if (!local.local) {
+			// Allocated on first use, so threads that never record anything don't cost any memory.
+			std::unique_lock<std::mutex> lock(_rings_lock);
+			if (!_free.empty()) {
+				local.local = std::move(_free.back());
+				_free.pop_back();
+			} else {
+				local.local = std::make_shared<ring>();
+				_rings.push_back(local.local);
+			}
+			local.thread = ++_threads;
+		}
+		return local;
+	}
+
+	static void escape(std::ostream& stream, const char* text)
+	{
+		for (const char* ptr = text; *ptr != 0; ptr++) {
+			switch (*ptr) {
+			case '"':
+				stream << "\\\"";
+				break;
+			case '\\':
+				stream << "\\\\";
+				break;
+			default:
+				if (static_cast<unsigned char>(*ptr) < 0x20) {
+					stream << ' ';
+				} else {
+					stream << *ptr;
+				}
+			}
+		}
+	}
+} // namespace util::tracing
+
+bool util::tracing::enabled()
+{
+	return _enabled.load(std::memory_order_relaxed);
+}
+
+void util::tracing::enable(bool enabled)
+{
+	if (enabled) {
+		_start.store(to_ns(std::chrono::steady_clock::now()));
+	}
+	_enabled.store(enabled);
+}
+
+void util::tracing::record(const char* category, const char* name, std::chrono::steady_clock::time_point begin,
+						   std::chrono::steady_clock::time_point end)
+{
+	owner&   self  = local_owner();
+	ring*    local = self.local.get();
+	uint64_t head  = local->head.load(std::memory_order_relaxed);
+	event    ev;
+
+	snprintf(ev.name, NAME_LENGTH, "%s", name);
+	ev.category = category;
+	ev.thread   = self.thread;
+	ev.begin    = to_ns(begin);
+	ev.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+	// Pairs with the fence in dump(): a reader that sees any of these words also sees the head that precedes them.
+	std::atomic_thread_fence(std::memory_order_release);
+	local->events[head & (RING_SIZE - 1)].store(ev);
+	local->head.store(head + 1, std::memory_order_release);
+}
+
+void util::tracing::dump(const std::filesystem::path& file)
+{
+	std::vector<std::shared_ptr<ring>> rings;
+	{
+		std::unique_lock<std::mutex> lock(_rings_lock);
+		rings = _rings;
+	}
+
+	if (file.has_parent_path()) {
+		std::filesystem::create_directories(file.parent_path());
+	}
+	std::ofstream stream(file, std::ios::trunc);
+	if (!stream.good()) {
+		throw std::ios_base::failure(file.string());
+	}
+
+	int64_t start = _start.load();
+	bool    first = true;
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	std::vector<event> events(RING_SIZE);
+	for (auto& local : rings) {
+		// Copy the ring first, as the owning thread keeps on writing to it.
+		uint64_t head = local->head.load(std::memory_order_acquire);
+		uint64_t base = (head > RING_SIZE) ? head - RING_SIZE : 0;
+		for (uint64_t idx = base; idx < head; idx++) {
+			local->events[idx & (RING_SIZE - 1)].load(events[idx - base]);
+		}
+
+		// Then drop anything the writer may have overwritten while we were copying. The fence keeps the load of head
+		//  below from moving ahead of the copies above.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t tail   = base;
+		uint64_t lapped = local->head.load(std::memory_order_acquire);
+		if (lapped >= RING_SIZE) {
+			tail = std::max(tail, lapped - RING_SIZE + 1);
+		}
+
+		for (uint64_t idx = tail; idx < head; idx++) {
+			auto& ev = events[idx - base];
+			if (ev.begin < start)
+				continue;
+
+			stream << (first ? "" : ",") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << ev.thread << ",\"cat\":\""
+				   << ev.category << "\",\"name\":\"";
+			escape(stream, ev.name);
+			stream << "\",\"ts\":" << (ev.begin / 1000) << "." << std::setfill('0') << std::setw(3)
+				   << (ev.begin % 1000) << ",\"dur\":" << (ev.duration / 1000) << "." << std::setw(3)
+				   << (ev.duration % 1000) << "}";
+			first = false;
+		}
+	}
+	stream << "]}";
+
+	DLOG_INFO(LOCAL_PREFIX "Wrote trace to '%s'.", file.string().c_str());
+}
+
+util::tracing::scope::scope(const char* category, const char* name) : _category(category), _name(name), _begin()
+{
+	if (enabled()) {
+		_begin = std::chrono::steady_clock::now();
+	}
+}
+
+util::tracing::scope::~scope()
+{
+	if (_begin.time_since_epoch().count() != 0) {
+		record(_category, _name, _begin, std::chrono::steady_clock::now());
+	}
+}
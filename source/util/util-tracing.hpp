@@ -0,0 +1,62 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <chrono>
+#include <filesystem>
+
+namespace util::tracing {
+	/** Check if spans are currently being recorded.
+	 *
+	 * Call sites should check this before doing any work to describe a span, like formatting a name.
+	 */
+	bool enabled();
+
+	/** Start or stop recording.
+	 *
+	 * Starting discards anything recorded before, so a dump only contains the time since the last start.
+	 */
+	void enable(bool enabled);
+
+	/** Record a finished span on the calling thread.
+	 *
+	 * Each thread records into its own ring buffer, so only the most recent spans of each thread are kept. Names
+	 * are copied and may be truncated, while the category must be a string literal.
+	 */
+	void record(const char* category, const char* name, std::chrono::steady_clock::time_point begin,
+				std::chrono::steady_clock::time_point end);
+
+	/** Write everything recorded so far as Chrome trace JSON.
+	 *
+	 * The result can be opened in chrome://tracing or https://ui.perfetto.dev.
+	 */
+	void dump(const std::filesystem::path& file);
+
+	// Records the lifetime of the object as a span, if tracing was enabled when it was created.
+	class scope {
+		const char*                           _category;
+		const char*                           _name;
+		std::chrono::steady_clock::time_point _begin;
+
+		public:
+		scope(const char* category, const char* name);
+		~scope();
+	};
+} // namespace util::tracing